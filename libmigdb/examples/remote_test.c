@@ -147,6 +147,19 @@ int main(int argc, char *argv[])
    }
  printf("Breakpoint %d @ function: %s\n",bk->number,bk->func);
 
+ /* Ask gdbserver to evaluate the conditions, it only stops when they are
+    true. The condition must be set to know if it was offloaded. */
+ if (!gmi_break_set_condition(h,bk->number,"1"))
+    printf("Error setting the condition\n");
+ else
+   {
+    int ce=gmi_break_set_cond_eval(h,ce_target);
+    if (ce<0)
+       printf("Error selecting the condition evaluation: %s\n",mi_get_error_str());
+    else
+       printf("Conditions evaluated by the %s\n",ce==ce_target ? "target" : "host");
+   }
+
  /* You can do things like:
  gmi_break_delete(h,bk->number);
  gmi_break_set_times(h,bk->number,2);
@@ -20,17 +20,21 @@
   Module: Allocator.
   Comments:
   Most alloc/free routines are here. Free routines must accept NULL
-pointers. Alloc functions must set mi_error.@p
+pointers. Alloc functions must set mi_error (using mi_set_error, they are
+also used by the reader thread).@p
   
 ***************************************************************************/
 
 #include "mi_gdb.h"
 
+/* From connect.c */
+void mi_set_error(int error);
+
 void *mi_calloc(size_t count, size_t sz)
 {
  void *res=calloc(count,sz);
  if (!res)
-    mi_error=MI_OUT_OF_MEMORY;
+    mi_set_error(MI_OUT_OF_MEMORY);
  return res;
 }
 
@@ -43,7 +47,7 @@ char *mi_malloc(size_t sz)
 {
  char *res=malloc(sz);
  if (!res)
-    mi_error=MI_OUT_OF_MEMORY;
+    mi_set_error(MI_OUT_OF_MEMORY);
  return res;
 }
 
@@ -93,6 +97,11 @@ mi_stop *mi_alloc_stop(void)
  return (mi_stop *)mi_calloc1(sizeof(mi_stop));
 }
 
+mi_event *mi_alloc_event(void)
+{
+ return (mi_event *)mi_calloc1(sizeof(mi_event));
+}
+
 mi_asm_insns *mi_alloc_asm_insns(void)
 {
  return (mi_asm_insns *)mi_calloc1(sizeof(mi_asm_insns));
@@ -108,6 +117,14 @@ mi_chg_reg *mi_alloc_chg_reg(void)
  return (mi_chg_reg *)mi_calloc1(sizeof(mi_chg_reg));
 }
 
+mi_thread *mi_alloc_thread(void)
+{
+ mi_thread *t=(mi_thread *)mi_calloc1(sizeof(mi_thread));
+ if (t)
+    t->core=-1;
+ return t;
+}
+
 /*****************************************************************************
   Free functions
 *****************************************************************************/
@@ -170,6 +187,7 @@ void mi_free_gvar_chg(mi_gvar_chg *p)
    {
     free(p->name);
     free(p->new_type);
+    free(p->value);
     aux=p->next;
     free(p);
     p=aux;
@@ -256,6 +274,20 @@ void mi_free_stop(mi_stop *s)
  free(s);
 }
 
+void mi_free_event(mi_event *e)
+{
+ if (!e)
+    return;
+ free(e->group_id);
+ mi_free_frames(e->frame);
+ free(e->name);
+ free(e->target_name);
+ free(e->host_name);
+ mi_free_bkpt(e->bkpt);
+ free(e->value);
+ free(e);
+}
+
 void mi_free_wp(mi_wp *wp)
 {
  mi_wp *aux;
@@ -320,3 +352,18 @@ void mi_free_chg_reg(mi_chg_reg *r)
    }
 }
 
+void mi_free_threads(mi_thread *t)
+{
+ mi_thread *aux;
+ while (t)
+   {
+    free(t->target_id);
+    free(t->name);
+    mi_free_frames(t->frame);
+    mi_free_frames(t->stack);
+    aux=t->next;
+    free(t);
+    t=aux;
+   }
+}
+
@@ -0,0 +1,432 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Disassembly cache.
+  Comments:
+  Keeps the disassembled instructions in an array sorted by address, the
+function names and the instructions are interned in a string table. A
+second sorted array holds the address ranges already disassembled, the
+overlapping and adjacent ranges are merged. Looking for the instruction
+at an address is a binary search. The instructions around it are the
+neighbours in the array.@p
+
+  Only the parts of a range that aren't in the cache are requested to gdb,
+all of them in a pipeline. The code doesn't change when the target runs,
+so the cache is valid until the code memory is written or the libraries
+are loaded or unloaded, pass the events to @x{mi_asm_cache_event}.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include "mi_gdb.h"
+
+/* From data_man.c */
+void mi_data_disassemble_se(mi_h *h, const char *start, const char *end,
+                            int mode);
+
+#define MI_ASM_CACHE_SLOTS 256
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates an empty disassembly cache.
+
+  Return: A new cache or NULL on error. Release it using
+@x{mi_free_asm_cache}.
+
+***************************************************************************/
+
+mi_asm_cache *mi_new_asm_cache()
+{
+ mi_asm_cache *c=(mi_asm_cache *)mi_calloc1(sizeof(mi_asm_cache));
+
+ if (!c)
+    return NULL;
+ c->strs=mi_new_strtab();
+ if (!c->strs)
+   {
+    free(c);
+    return NULL;
+   }
+ return c;
+}
+
+void mi_free_asm_cache(mi_asm_cache *c)
+{
+ if (!c)
+    return;
+ mi_free_strtab(c->strs);
+ free(c->recs);
+ free(c->ranges);
+ free(c);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Forgets all the instructions.
+
+***************************************************************************/
+
+void mi_asm_cache_flush(mi_asm_cache *c)
+{
+ mi_strtab *s=mi_new_strtab();
+
+ /* Release the strings only if we can get a new table. */
+ if (s)
+   {
+    mi_free_strtab(c->strs);
+    c->strs=s;
+   }
+ c->nrecs=c->nranges=0;
+}
+
+/* First record with addr>=a. */
+static
+int mi_asm_lower(mi_asm_cache *c, unsigned long a)
+{
+ int lo=0, hi=c->nrecs, mid;
+
+ while (lo<hi)
+   {
+    mid=(lo+hi)/2;
+    if ((unsigned long)c->recs[mid].addr<a)
+       lo=mid+1;
+    else
+       hi=mid;
+   }
+ return lo;
+}
+
+/* First range with end>a. */
+static
+int mi_asm_range_lower(mi_asm_cache *c, unsigned long a)
+{
+ int lo=0, hi=c->nranges, mid;
+
+ while (lo<hi)
+   {
+    mid=(lo+hi)/2;
+    if ((unsigned long)c->ranges[mid].end<=a)
+       lo=mid+1;
+    else
+       hi=mid;
+   }
+ return lo;
+}
+
+static
+int mi_asm_reserve(void **p, int *size, int need, int esize)
+{
+ void *n;
+ int ns;
+
+ if (need<=*size)
+    return 1;
+ ns=*size ? *size : MI_ASM_CACHE_SLOTS;
+ while (ns<need)
+    ns*=2;
+ n=realloc(*p,ns*esize);
+ if (!n)
+   {
+    mi_error=MI_OUT_OF_MEMORY;
+    return 0;
+   }
+ *p=n;
+ *size=ns;
+ return 1;
+}
+
+/* Marks [start,end) as cached, merging with the ranges it touches. */
+static
+int mi_asm_add_range(mi_asm_cache *c, void *start, void *end)
+{
+ int i=mi_asm_range_lower(c,(unsigned long)start), j;
+
+ /* Also merge an adjacent range that ends at start. */
+ if (i>0 && c->ranges[i-1].end==start)
+    i--;
+ for (j=i; j<c->nranges && c->ranges[j].start<=end; j++)
+    {
+     if (c->ranges[j].start<start)
+        start=c->ranges[j].start;
+     if (c->ranges[j].end>end)
+        end=c->ranges[j].end;
+    }
+ if (j==i)
+   {/* A new one. */
+    if (!mi_asm_reserve((void **)&c->ranges,&c->aranges,c->nranges+1,
+                        sizeof(mi_asm_range)))
+       return 0;
+    memmove(c->ranges+i+1,c->ranges+i,(c->nranges-i)*sizeof(mi_asm_range));
+    c->nranges++;
+   }
+ else if (j>i+1)
+   {/* Merged, remove the extra ones. */
+    memmove(c->ranges+i+1,c->ranges+j,(c->nranges-j)*sizeof(mi_asm_range));
+    c->nranges-=j-i-1;
+   }
+ c->ranges[i].start=start;
+ c->ranges[i].end=end;
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Adds the instructions disassembled from the @var{start} to @var{end}
+range, @var{end} not included. The instructions already cached in this
+range are replaced.
+
+  Return: !=0 OK
+
+***************************************************************************/
+
+int mi_asm_cache_add(mi_asm_cache *c, void *start, void *end, mi_asm_insn *ins)
+{
+ mi_asm_insn *i;
+ mi_asm_rec *r;
+ int n=0, lo, hi, diff;
+
+ for (i=ins; i; i=i->next)
+     if (i->addr>=start && i->addr<end)
+        n++;
+ lo=mi_asm_lower(c,(unsigned long)start);
+ hi=mi_asm_lower(c,(unsigned long)end);
+ diff=n-(hi-lo);
+ if (!mi_asm_reserve((void **)&c->recs,&c->arecs,c->nrecs+diff,
+                     sizeof(mi_asm_rec)))
+    return 0;
+ memmove(c->recs+hi+diff,c->recs+hi,(c->nrecs-hi)*sizeof(mi_asm_rec));
+ c->nrecs+=diff;
+ /* gdb reports them in order. */
+ for (r=c->recs+lo, i=ins; i; i=i->next)
+    {
+     if (i->addr<start || i->addr>=end)
+        continue;
+     r->addr=i->addr;
+     r->offset=i->offset;
+     r->func=i->func ? mi_strtab_intern(c->strs,i->func) : -1;
+     r->inst=mi_strtab_intern(c->strs,i->inst ? i->inst : "");
+     r++;
+    }
+ return mi_asm_add_range(c,start,end);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Removes the cached ranges that overlap the @var{len} bytes at
+@var{addr}. Use it when the code is modified. The whole ranges are
+removed because on CPUs with variable length instructions the
+disassembly after the change could be different.
+
+  Return: The number of instructions removed.
+
+***************************************************************************/
+
+int mi_asm_cache_invalidate(mi_asm_cache *c, void *addr, int len)
+{
+ int i=mi_asm_range_lower(c,(unsigned long)addr), j, lo, hi, n=0;
+ char *end=(char *)addr+(len>0 ? len : 1);
+
+ for (j=i; j<c->nranges && (char *)c->ranges[j].start<end; j++)
+    {
+     lo=mi_asm_lower(c,(unsigned long)c->ranges[j].start);
+     hi=mi_asm_lower(c,(unsigned long)c->ranges[j].end);
+     memmove(c->recs+lo,c->recs+hi,(c->nrecs-hi)*sizeof(mi_asm_rec));
+     c->nrecs-=hi-lo;
+     n+=hi-lo;
+    }
+ memmove(c->ranges+i,c->ranges+j,(c->nranges-j)*sizeof(mi_asm_range));
+ c->nranges-=j-i;
+ return n;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Updates the cache using an asynchronous event. The memory-changed event
+invalidates the modified range and the library events flush the cache.
+These notifications must be enabled, see @x{mi_set_notify_mask}.
+
+  Return: !=0 if the cache was modified.
+
+***************************************************************************/
+
+int mi_asm_cache_event(mi_asm_cache *c, mi_event *e)
+{
+ switch (e->type)
+   {
+    case MI_CL_MEMORY_CHANGED:
+         return mi_asm_cache_invalidate(c,e->addr,e->len)>0;
+    case MI_CL_LIBRARY_LOADED:
+    case MI_CL_LIBRARY_UNLOADED:
+         if (!c->nrecs)
+            return 0;
+         mi_asm_cache_flush(c);
+         return 1;
+   }
+ return 0;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Looks for the instruction containing @var{addr}.
+
+  Return: The index of the instruction in the recs array or -1 if the
+address isn't in the cache. The instructions before and after it are the
+previous and next indexes, use @x{mi_asm_cache_range_of} to know where
+the cached range ends.
+
+***************************************************************************/
+
+int mi_asm_cache_find(mi_asm_cache *c, void *addr)
+{
+ int r=mi_asm_range_lower(c,(unsigned long)addr), i;
+
+ if (r>=c->nranges || c->ranges[r].start>addr)
+    return -1;
+ i=mi_asm_lower(c,(unsigned long)addr);
+ if (i<c->nrecs && c->recs[i].addr==addr)
+    return i;
+ /* Inside the previous instruction. */
+ if (i>0 && c->recs[i-1].addr>=c->ranges[r].start)
+    return i-1;
+ return -1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Finds the cached range containing the instruction @var{index}. The
+instructions of the range are from @var{first} to @var{last}.
+
+  Return: !=0 if found.
+
+***************************************************************************/
+
+int mi_asm_cache_range_of(mi_asm_cache *c, int index, int *first, int *last)
+{
+ int r;
+
+ if (index<0 || index>=c->nrecs)
+    return 0;
+ r=mi_asm_range_lower(c,(unsigned long)c->recs[index].addr);
+ if (r>=c->nranges)
+    return 0;
+ *first=mi_asm_lower(c,(unsigned long)c->ranges[r].start);
+ *last=mi_asm_lower(c,(unsigned long)c->ranges[r].end)-1;
+ return 1;
+}
+
+/* Strings of a record. */
+const char *mi_asm_cache_func(mi_asm_cache *c, mi_asm_rec *r)
+{
+ return r->func>=0 ? mi_strtab_str(c->strs,r->func) : NULL;
+}
+
+const char *mi_asm_cache_inst(mi_asm_cache *c, mi_asm_rec *r)
+{
+ return mi_strtab_str(c->strs,r->inst);
+}
+
+typedef struct
+{
+ mi_asm_cache *c;
+ void **starts, **ends;
+} mi_asm_batch;
+
+static
+void mi_asm_send(mi_h *h, int i, void *data)
+{
+ mi_asm_batch *b=(mi_asm_batch *)data;
+ char s[32], e[32];
+
+ snprintf(s,32,"%p",b->starts[i]);
+ snprintf(e,32,"%p",b->ends[i]);
+ mi_data_disassemble_se(h,s,e,0);
+}
+
+static
+int mi_asm_recv(mi_h *h, int i, void *data)
+{
+ mi_asm_batch *b=(mi_asm_batch *)data;
+ mi_asm_insns *l=mi_get_asm_insns(h);
+ int ok=0;
+
+ if (l)
+    ok=mi_asm_cache_add(b->c,b->starts[i],b->ends[i],l->ins);
+ mi_free_asm_insns(l);
+ return ok;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Makes sure the @var{start} to @var{end} range is in the cache. Only the
+gaps are disassembled, using a pipeline. A gap that starts where a cached
+range ends is requested from the last instruction of the range, so the
+instructions are decoded from a known boundary.
+
+  Command: -data-disassemble
+  Return: The index of the instruction at @var{start} or -1 on error.
+
+***************************************************************************/
+
+int gmi_asm_cache_fetch(mi_h *h, mi_asm_cache *c, void *start, void *end)
+{
+ mi_asm_batch b;
+ void *cur=start;
+ int r, n=0, ret;
+
+ if (end<=start)
+    return -1;
+ /* At most one gap per range plus one. */
+ r=mi_asm_range_lower(c,(unsigned long)start);
+ b.starts=(void **)mi_malloc((c->nranges-r+1)*2*sizeof(void *));
+ if (!b.starts)
+    return -1;
+ b.ends=b.starts+c->nranges-r+1;
+ for (; cur<end; r++)
+    {
+     if (r<c->nranges && c->ranges[r].start<=cur)
+       {/* Cached, skip it. */
+        cur=c->ranges[r].end;
+        continue;
+       }
+     b.starts[n]=cur;
+     if (cur!=start && r>0 && c->ranges[r-1].end==cur)
+       {
+        int i=mi_asm_lower(c,(unsigned long)cur);
+        if (i>0 && c->recs[i-1].addr>=c->ranges[r-1].start)
+           b.starts[n]=c->recs[i-1].addr;
+       }
+     b.ends[n]=r<c->nranges && c->ranges[r].start<end ? c->ranges[r].start : end;
+     cur=b.ends[n++];
+     r--;
+    }
+ b.c=c;
+ ret=n ? mi_pipeline(h,n,mi_asm_send,mi_asm_recv,&b) : 0;
+ free(b.starts);
+ if (ret!=n)
+    return -1;
+ return mi_asm_cache_find(c,start);
+}
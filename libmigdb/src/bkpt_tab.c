@@ -0,0 +1,559 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Breakpoint table.
+  Comments:
+  Owns the breakpoints of a session and indexes them by number (hnext
+chain) and by location (lnext chain). The location is file:line, or the
+address for the breakpoints without source information. So the bkptno of
+a mi_stop can be matched without scanning a list.@p
+
+  The bulk operations send all the commands in a pipeline
+(@x{mi_pipeline}) and update the table from the replies, inserting
+thousands of breakpoints costs about the same as one round trip.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include "mi_gdb.h"
+
+#define MI_BTAB_SLOTS 256
+
+/* From breakpoint.c */
+void mi_break_insert(mi_h *h, int temporary, int hard_assist,
+                     const char *cond, int count, int thread,
+                     const char *where);
+void mi_break_delete(mi_h *h, int number);
+void mi_break_enable(mi_h *h, int number);
+void mi_break_disable(mi_h *h, int number);
+
+static
+unsigned mi_btab_hash_num(int number)
+{
+ return (unsigned)number*2654435761u;
+}
+
+static
+unsigned mi_btab_hash_loc(const char *file, int line, void *addr)
+{
+ unsigned hash=2166136261u;
+
+ if (!file)
+    return ((unsigned)(unsigned long)addr)*16777619u;
+ for (; *file; file++)
+    {
+     hash^=(unsigned char)*file;
+     hash*=16777619u;
+    }
+ return (hash^(unsigned)line)*16777619u;
+}
+
+static
+unsigned mi_btab_loc_of(mi_bkpt *b)
+{
+ return mi_btab_hash_loc(b->file,b->line,b->addr);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates an empty breakpoint table.
+
+  Return: A new table or NULL on error. Release it using
+@x{mi_free_bkpt_tab}.
+
+***************************************************************************/
+
+mi_bkpt_tab *mi_new_bkpt_tab()
+{
+ mi_bkpt_tab *t=(mi_bkpt_tab *)mi_calloc1(sizeof(mi_bkpt_tab));
+
+ if (!t)
+    return NULL;
+ t->buckets=MI_BTAB_SLOTS;
+ t->num=(mi_bkpt **)mi_calloc(t->buckets,sizeof(mi_bkpt *));
+ t->loc=(mi_bkpt **)mi_calloc(t->buckets,sizeof(mi_bkpt *));
+ if (!t->num || !t->loc)
+   {
+    mi_free_bkpt_tab(t);
+    return NULL;
+   }
+ return t;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Releases the table and all the breakpoints it owns. The breakpoints
+aren't deleted in gdb.
+
+***************************************************************************/
+
+void mi_free_bkpt_tab(mi_bkpt_tab *t)
+{
+ if (!t)
+    return;
+ mi_free_bkpt(t->list);
+ free(t->num);
+ free(t->loc);
+ free(t);
+}
+
+static
+void mi_btab_link(mi_bkpt_tab *t, mi_bkpt *b)
+{
+ unsigned mask=t->buckets-1;
+ mi_bkpt **p;
+
+ p=t->num+(mi_btab_hash_num(b->number) & mask);
+ b->hnext=*p;
+ *p=b;
+ p=t->loc+(mi_btab_loc_of(b) & mask);
+ b->lnext=*p;
+ *p=b;
+}
+
+static
+void mi_btab_grow(mi_bkpt_tab *t)
+{
+ int nb=t->buckets*2;
+ mi_bkpt **nn=(mi_bkpt **)calloc(nb,sizeof(mi_bkpt *));
+ mi_bkpt **nl=(mi_bkpt **)calloc(nb,sizeof(mi_bkpt *));
+ mi_bkpt *b;
+
+ /* Not fatal, the chains just get longer. */
+ if (!nn || !nl)
+   {
+    free(nn);
+    free(nl);
+    return;
+   }
+ free(t->num);
+ free(t->loc);
+ t->num=nn;
+ t->loc=nl;
+ t->buckets=nb;
+ for (b=t->list; b; b=b->next)
+     mi_btab_link(t,b);
+}
+
+/* The list is double linked, so a breakpoint is removed in O(1). */
+static
+void mi_btab_list_unlink(mi_bkpt_tab *t, mi_bkpt *b)
+{
+ if (b->prev)
+    b->prev->next=b->next;
+ else
+    t->list=b->next;
+ if (b->next)
+    b->next->prev=b->prev;
+ b->next=b->prev=NULL;
+ t->count--;
+}
+
+static
+void mi_btab_unlink(mi_bkpt_tab *t, mi_bkpt *b)
+{
+ unsigned mask=t->buckets-1;
+ mi_bkpt **p;
+
+ for (p=t->num+(mi_btab_hash_num(b->number) & mask); *p; p=&(*p)->hnext)
+     if (*p==b)
+       {
+        *p=b->hnext;
+        break;
+       }
+ for (p=t->loc+(mi_btab_loc_of(b) & mask); *p; p=&(*p)->lnext)
+     if (*p==b)
+       {
+        *p=b->lnext;
+        break;
+       }
+ b->hnext=b->lnext=NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Looks for the breakpoint @var{number}, i.e. the bkptno of a mi_stop.
+
+  Return: The breakpoint, owned by the table, or NULL if not found.
+
+***************************************************************************/
+
+mi_bkpt *mi_bkpt_tab_find(mi_bkpt_tab *t, int number)
+{
+ mi_bkpt *b=t->num[mi_btab_hash_num(number) & (t->buckets-1)];
+
+ for (; b; b=b->hnext)
+     if (b->number==number)
+        return b;
+ return NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Looks for a breakpoint at @var{file}:@var{line}. The file name must be
+the one reported by gdb.
+
+  Return: The first breakpoint found, owned by the table, or NULL.
+
+***************************************************************************/
+
+mi_bkpt *mi_bkpt_tab_find_loc(mi_bkpt_tab *t, const char *file, int line)
+{
+ mi_bkpt *b=t->loc[mi_btab_hash_loc(file,line,NULL) & (t->buckets-1)];
+
+ for (; b; b=b->lnext)
+     if (b->file && b->line==line && strcmp(b->file,file)==0)
+        return b;
+ return NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Looks for a breakpoint at @var{addr}. Only the breakpoints without
+source information are indexed by address.
+
+  Return: The first breakpoint found, owned by the table, or NULL.
+
+***************************************************************************/
+
+mi_bkpt *mi_bkpt_tab_find_addr(mi_bkpt_tab *t, void *addr)
+{
+ mi_bkpt *b=t->loc[mi_btab_hash_loc(NULL,0,addr) & (t->buckets-1)];
+
+ for (; b; b=b->lnext)
+     if (!b->file && b->addr==addr)
+        return b;
+ return NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Adds a breakpoint to the table, the table becomes the owner. If the
+table already has a breakpoint with the same number it's replaced.
+
+***************************************************************************/
+
+void mi_bkpt_tab_add(mi_bkpt_tab *t, mi_bkpt *b)
+{
+ mi_bkpt *old=mi_bkpt_tab_find(t,b->number);
+
+ if (old)
+    mi_bkpt_tab_remove(t,old);
+ if (t->count>=t->buckets)
+    mi_btab_grow(t);
+ b->next=t->list;
+ b->prev=NULL;
+ if (t->list)
+    t->list->prev=b;
+ t->list=b;
+ mi_btab_link(t,b);
+ t->count++;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Removes the breakpoint from the table and releases it. The breakpoint
+isn't deleted in gdb.
+
+***************************************************************************/
+
+void mi_bkpt_tab_remove(mi_bkpt_tab *t, mi_bkpt *b)
+{
+ mi_btab_unlink(t,b);
+ mi_btab_list_unlink(t,b);
+ mi_free_bkpt(b);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Applies a breakpoint-created/modified/deleted event (see
+@x{mi_get_event}), generated when the breakpoints are changed using CLI
+commands. For created and modified the table takes the bkpt field of the
+event. Other events are ignored. The breakpoint notifications must be
+enabled, see @x{mi_set_notify_mask}.
+
+  Return: !=0 if the table was changed.
+
+***************************************************************************/
+
+int mi_bkpt_tab_event(mi_bkpt_tab *t, mi_event *e)
+{
+ mi_bkpt *b;
+
+ switch (e->type)
+   {
+    case MI_CL_BREAKPOINT_CREATED:
+    case MI_CL_BREAKPOINT_MODIFIED:
+         if (!e->bkpt)
+            return 0;
+         b=mi_bkpt_tab_find(t,e->bkpt->number);
+         if (b)
+           {/* Keep the fields filled by the user. */
+            e->bkpt->mode=b->mode;
+            e->bkpt->thread=b->thread;
+            e->bkpt->file_abs=b->file_abs;
+            b->file_abs=NULL;
+           }
+         mi_bkpt_tab_add(t,e->bkpt);
+         e->bkpt=NULL;
+         return 1;
+    case MI_CL_BREAKPOINT_DELETED:
+         b=mi_bkpt_tab_find(t,e->id);
+         if (!b)
+            return 0;
+         mi_bkpt_tab_remove(t,b);
+         return 1;
+   }
+ return 0;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates the location for -break-insert using the mode field of @var{b}.
+
+  Return: !=0 OK, 0 if the location doesn't fit in @var{buf}.
+
+***************************************************************************/
+
+int mi_bkpt_where(mi_bkpt *b, char *buf, int size)
+{
+ int l=0;
+
+ switch (b->mode)
+   {
+    case m_file_line:
+         l=snprintf(buf,size,"%s:%d",b->file,b->line);
+         break;
+    case m_function:
+         l=snprintf(buf,size,"%s",b->func);
+         break;
+    case m_file_function:
+         l=snprintf(buf,size,"%s:%s",b->file,b->func);
+         break;
+    case m_address:
+         l=snprintf(buf,size,"*%p",b->addr);
+         break;
+   }
+ return l>0 && l<size;
+}
+
+/* Bulk insert. */
+typedef struct
+{
+ mi_bkpt_tab *t;
+ mi_bkpt **reqs;
+} mi_btab_ins;
+
+/* Sends the -break-insert for the r request. */
+void mi_bkpt_insert_req(mi_h *h, mi_bkpt *r)
+{
+ char where[1024];
+
+ if (!mi_bkpt_where(r,where,sizeof(where)))
+    /* Let gdb report the error, we must send something. */
+    where[0]=0;
+ mi_break_insert(h,r->disp==d_del,r->type==t_hw,r->cond,
+                 r->ignore>0 ? r->ignore : -1,
+                 r->thread>0 ? r->thread : -1,where);
+}
+
+/* Gets the reply for the r request and adds the breakpoint to the table. */
+int mi_bkpt_tab_res_req(mi_h *h, mi_bkpt_tab *t, mi_bkpt *r)
+{
+ mi_bkpt *b=mi_res_bkpt(h);
+
+ if (!b)
+   {
+    r->number=0;
+    return 0;
+   }
+ b->mode=r->mode;
+ b->thread=r->thread;
+ r->number=b->number;
+ mi_bkpt_tab_add(t,b);
+ return 1;
+}
+
+static
+void mi_btab_ins_send(mi_h *h, int i, void *data)
+{
+ mi_bkpt_insert_req(h,((mi_btab_ins *)data)->reqs[i]);
+}
+
+static
+int mi_btab_ins_recv(mi_h *h, int i, void *data)
+{
+ mi_btab_ins *d=(mi_btab_ins *)data;
+
+ return mi_bkpt_tab_res_req(h,d->t,d->reqs[i]);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Inserts the breakpoints described by the @var{reqs} list, i.e. the ones
+saved from a previous session. The location is created using the mode
+field (see @x{mi_bkpt_where}), disp, type, cond, ignore and thread are
+also used. All the commands are sent in a pipeline and the new breakpoints
+are added to the table. The number field of each request is set to the
+number assigned by gdb, 0 if it failed.
+
+  Command: -break-insert
+  Return: The number of breakpoints inserted or -1 if gdb died.
+
+***************************************************************************/
+
+int gmi_bkpt_tab_insert(mi_h *h, mi_bkpt_tab *t, mi_bkpt *reqs)
+{
+ mi_btab_ins d;
+ mi_bkpt *r;
+ int n=0, ret;
+
+ for (r=reqs; r; r=r->next)
+     n++;
+ if (!n)
+    return 0;
+ d.t=t;
+ d.reqs=(mi_bkpt **)mi_malloc(n*sizeof(mi_bkpt *));
+ if (!d.reqs)
+    return -1;
+ for (n=0, r=reqs; r; r=r->next)
+     d.reqs[n++]=r;
+ ret=mi_pipeline(h,n,mi_btab_ins_send,mi_btab_ins_recv,&d);
+ free(d.reqs);
+ return ret;
+}
+
+/* Bulk delete/enable/disable. */
+typedef struct
+{
+ mi_bkpt_tab *t;
+ int *numbers;
+ int op; /* 0 delete, 1 enable, 2 disable */
+} mi_btab_op;
+
+static
+void mi_btab_op_send(mi_h *h, int i, void *data)
+{
+ mi_btab_op *d=(mi_btab_op *)data;
+
+ switch (d->op)
+   {
+    case 0:
+         mi_break_delete(h,d->numbers[i]);
+         break;
+    case 1:
+         mi_break_enable(h,d->numbers[i]);
+         break;
+    default:
+         mi_break_disable(h,d->numbers[i]);
+   }
+}
+
+static
+int mi_btab_op_recv(mi_h *h, int i, void *data)
+{
+ mi_btab_op *d=(mi_btab_op *)data;
+ mi_bkpt *b;
+
+ if (!mi_res_simple_done(h))
+    return 0;
+ b=mi_bkpt_tab_find(d->t,d->numbers[i]);
+ if (b)
+   {
+    if (d->op)
+       b->enabled=d->op==1;
+    else
+       /* Just unindexed, the list is swept later. */
+       mi_btab_unlink(d->t,b);
+   }
+ return 1;
+}
+
+static
+int mi_btab_run_op(mi_h *h, mi_bkpt_tab *t, int *numbers, int count, int op)
+{
+ mi_btab_op d;
+ mi_bkpt *b, *next;
+ int ret;
+
+ if (count<=0)
+    return 0;
+ d.t=t;
+ d.numbers=numbers;
+ d.op=op;
+ ret=mi_pipeline(h,count,mi_btab_op_send,mi_btab_op_recv,&d);
+ if (op==0)
+   {/* Release the deleted ones in one pass. */
+    for (b=t->list; b; b=next)
+       {
+        next=b->next;
+        if (mi_bkpt_tab_find(t,b->number)!=b)
+          {
+           mi_btab_list_unlink(t,b);
+           mi_free_bkpt(b);
+          }
+       }
+   }
+ return ret;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Deletes the @var{count} breakpoints listed in @var{numbers}. All the
+commands are sent in a pipeline and the deleted breakpoints are removed
+from the table and released.
+
+  Command: -break-delete
+  Return: The number of breakpoints deleted or -1 if gdb died.
+
+***************************************************************************/
+
+int gmi_bkpt_tab_delete(mi_h *h, mi_bkpt_tab *t, int *numbers, int count)
+{
+ return mi_btab_run_op(h,t,numbers,count,0);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Enables or disables the @var{count} breakpoints listed in @var{numbers}.
+All the commands are sent in a pipeline and the enabled field of the
+breakpoints in the table is updated.
+
+  Command: -break-enable/-break-disable
+  Return: The number of breakpoints changed or -1 if gdb died.
+
+***************************************************************************/
+
+int gmi_bkpt_tab_enable(mi_h *h, mi_bkpt_tab *t, int *numbers, int count,
+                        int enable)
+{
+ return mi_btab_run_op(h,t,numbers,count,enable ? 1 : 2);
+}
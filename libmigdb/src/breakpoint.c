@@ -25,14 +25,16 @@
 gdb command:          Implemented?
 
 -break-after          Yes
+-break-commands       Yes
 -break-condition      Yes
 -break-delete         Yes
 -break-disable        Yes
 -break-enable         Yes
 -break-info           N.A. (info break NUMBER) (*)
 -break-insert         Yes
--break-list           No (*)
+-break-list           Yes
 -break-watch          Yes
+-dprintf-insert       Yes
 @</pre>
 
 (*) I think the program should keep track of the breakpoints, so it will
@@ -40,8 +42,63 @@ be implemented when I have more time.@p
 
 ***************************************************************************/
 
+#include <string.h>
 #include "mi_gdb.h"
 
+/* Returns a copy of s as a quoted C string. */
+static
+char *mi_quote_str(const char *s)
+{
+ char *r=(char *)mi_malloc(strlen(s)*2+3), *d;
+
+ if (!r)
+    return NULL;
+ d=r;
+ *(d++)='"';
+ for (; *s; s++)
+    {
+     if (*s=='"' || *s=='\\')
+        *(d++)='\\';
+     else if (*s=='\n')
+       {
+        *(d++)='\\';
+        *(d++)='n';
+        continue;
+       }
+     *(d++)=*s;
+    }
+ *(d++)='"';
+ *d=0;
+ return r;
+}
+
+/* Returns the strings quoted and separated by spaces. */
+static
+char *mi_quote_list(const char **l, int count)
+{
+ int i, len=1;
+ char *s, *c, *q;
+
+ for (i=0; i<count; i++)
+     len+=strlen(l[i])*2+3;
+ s=c=(char *)mi_malloc(len);
+ if (!s)
+    return NULL;
+ *s=0;
+ for (i=0; i<count; i++)
+    {
+     q=mi_quote_str(l[i]);
+     if (!q)
+       {
+        free(s);
+        return NULL;
+       }
+     c+=sprintf(c,"%s%s",i ? " " : "",q);
+     free(q);
+    }
+ return s;
+}
+
 /* Low level versions. */
 
 void mi_break_insert_fl(mi_h *h, const char *file, int line)
@@ -125,6 +182,53 @@ void mi_break_disable(mi_h *h, int number)
  mi_send(h,"-break-disable %d\n",number);
 }
 
+/* The format and the arguments are quoted. */
+int mi_dprintf_insert(mi_h *h, int temporary, const char *cond, int count,
+                      int thread, const char *where, const char *format,
+                      const char **args, int nargs)
+{
+ char s_count[32];
+ char s_thread[32];
+ char *fmt=mi_quote_str(format), *a=mi_quote_list(args,nargs);
+
+ if (!fmt || !a)
+   {
+    free(fmt);
+    free(a);
+    return 0;
+   }
+ if (count>=0)
+    snprintf(s_count,32,"%d",count);
+ if (thread>=0)
+    snprintf(s_thread,32,"%d",thread);
+ mi_send(h,"-dprintf-insert %s %s%s%s %s %s %s %s %s %s %s\n",
+         temporary   ? "-t" : "",
+         cond        ? "-c \"" : "", cond ? cond : "", cond ? "\"" : "",
+         count>=0    ? "-i" : "", count>=0  ? s_count  : "",
+         thread>=0   ? "-p" : "", thread>=0 ? s_thread : "",
+         where,fmt,a);
+ free(fmt);
+ free(a);
+ return 1;
+}
+
+/* Each command is quoted. */
+int mi_break_commands(mi_h *h, int number, const char **cmds, int count)
+{
+ char *s=mi_quote_list(cmds,count);
+
+ if (!s)
+    return 0;
+ mi_send(h,"-break-commands %d %s\n",number,s);
+ free(s);
+ return 1;
+}
+
+void mi_break_list(mi_h *h)
+{
+ mi_send(h,"-break-list\n");
+}
+
 void mi_break_watch(mi_h *h, enum mi_wp_mode mode, const char *exp)
 {
  if (mode==wm_write)
@@ -277,3 +381,117 @@ mi_wp *gmi_break_watch(mi_h *h, enum mi_wp_mode mode, const char *exp)
  return mi_res_wp(h);
 }
 
+
+/**[txh]********************************************************************
+
+  Description:
+  Insert a dynamic printf. When the target reaches @var{where} gdb prints
+@var{format} using the @var{nargs} expressions in @var{args} and resumes
+the target, no stop is reported. The format and the expressions are
+quoted by this function. gdb 7.7 or newer.
+
+  Command: -dprintf-insert
+  Return: A new mi_bkpt structure with info about the dprintf. NULL on
+error.
+
+***************************************************************************/
+
+mi_bkpt *gmi_dprintf_insert(mi_h *h, int temporary, const char *cond,
+                            int count, int thread, const char *where,
+                            const char *format, const char **args,
+                            int nargs)
+{
+ if (!mi_dprintf_insert(h,temporary,cond,count,thread,where,format,args,
+                        nargs))
+    return NULL;
+ return mi_res_bkpt(h);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Sets the @var{count} commands executed when the breakpoint is hit. For
+tracepoints they are the actions, i.e. "collect $regs". Use 0 commands to
+clear them.
+
+  Command: -break-commands
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_break_commands(mi_h *h, int number, const char **cmds, int count)
+{
+ if (!mi_break_commands(h,number,cmds,count))
+    return 0;
+ return mi_res_simple_done(h);
+}
+
+static
+const char *mi_cond_eval_names[]={"auto","host","target"};
+
+/**[txh]********************************************************************
+
+  Description:
+  Selects where the breakpoint conditions are evaluated. With ce_target
+and a target that supports it (i.e. gdbserver) the conditions are sent to
+the target and the target only stops when the condition is true. If gdb
+refuses the target mode we fall back to the host mode. Note that gdb
+accepts the target mode even when the stub can't evaluate the conditions,
+in this case they are silently evaluated by the host. For this reason the
+mode in use is taken from the evaluated-by field of the breakpoints with
+conditions (see @x{gmi_break_list}), so set the conditions before calling
+it to know if they were offloaded. gdb 7.5 or newer.
+
+  Command: -gdb-set breakpoint condition-evaluation + -break-list
+  Return: ce_target if at least one condition is evaluated by the target,
+ce_host if they are evaluated by the host, ce_auto if there are no
+conditions to check and -1 on error.
+
+***************************************************************************/
+
+int gmi_break_set_cond_eval(mi_h *h, enum mi_cond_eval mode)
+{
+ const char *var="breakpoint condition-evaluation";
+ mi_bkpt *l, *b;
+ int ret=ce_auto;
+
+ if (!gmi_gdb_set(h,var,mi_cond_eval_names[mode]) &&
+     (mode!=ce_target || !gmi_gdb_set(h,var,"host")))
+    return -1;
+ mi_error=MI_OK;
+ l=gmi_break_list(h);
+ if (!l && mi_error!=MI_OK)
+    return -1;
+ for (b=l; b; b=b->next)
+     if (b->cond)
+       {
+        if (b->cond_target)
+          {
+           ret=ce_target;
+           break;
+          }
+        ret=ce_host;
+       }
+ mi_free_bkpt(l);
+ return ret;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the list of breakpoints, watchpoints, tracepoints, etc. The
+locations of breakpoints with multiple locations aren't included. The
+times field has the current hit count and, when there is a condition,
+cond_target indicates if it's evaluated by the target.
+
+  Command: -break-list
+  Return: A new list of mi_bkpt structures or NULL if there are no
+breakpoints or on error (check mi_error).
+
+***************************************************************************/
+
+mi_bkpt *gmi_break_list(mi_h *h)
+{
+ mi_break_list(h);
+ return mi_res_break_list(h);
+}
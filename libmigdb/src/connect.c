@@ -51,8 +51,31 @@ in a row.
  #define TEMP_FAILURE_RETRY(a) (a)
 #endif
 
+/* From parse.c */
+mi_results *mi_get_var(mi_output *res, const char *var);
+/* From reader.c */
+int mi_reader_get(mi_h *h, mi_output **o);
+/* From hit_stats.c */
+void mi_hit_stats_record(mi_h *h, mi_output *o);
+
+/* Checks if we want this =notify record, before parsing it. Also used by
+   the reader thread. */
+int mi_want_notify(mi_h *h, const char *str)
+{
+ int tclass=mi_get_async_class(str,NULL);
+
+ /* The thread states needs them. */
+ if (__atomic_load_n(&h->non_stop,__ATOMIC_RELAXED) &&
+     (tclass==MI_CL_THREAD_CREATED || tclass==MI_CL_THREAD_EXITED))
+    return 1;
+ return (__atomic_load_n(&h->notify_mask,__ATOMIC_RELAXED) &
+         MI_EV_MASK(tclass))!=0;
+}
+
 int mi_error=MI_OK;
 char *mi_error_from_gdb=NULL;
+/* The reader thread reports the errors in its own slot, see reader.c */
+static __thread int *mi_error_slot=NULL;
 static char *gdb_exe=NULL;
 static char *xterm_exe=NULL;
 static char *gdb_start=NULL;
@@ -60,6 +83,21 @@ static char *gdb_conn=NULL;
 static char *main_func=NULL;
 static char  disable_psym_search_workaround=0;
 
+/* Used by the code that can run in the reader thread, the application
+   errors aren't changed from there. */
+void mi_set_error(int error)
+{
+ if (mi_error_slot)
+    *mi_error_slot=error;
+ else
+    mi_error=error;
+}
+
+void mi_set_error_slot(int *slot)
+{
+ mi_error_slot=slot;
+}
+
 mi_h *mi_alloc_h()
 {
  mi_h *h=(mi_h *)calloc(1,sizeof(mi_h));
@@ -70,6 +108,7 @@ mi_h *mi_alloc_h()
    }
  h->to_gdb[0]=h->to_gdb[1]=h->from_gdb[0]=h->from_gdb[1]=-1;
  h->pid=-1;
+ h->notify_mask=MI_EV_DEFAULT;
  return h;
 }
 
@@ -109,6 +148,7 @@ void mi_kill_child(pid_t pid)
 void mi_free_h(mi_h **handle)
 {
  mi_h *h=*handle;
+ mi_stop_reader(h);
  if (h->to_gdb[0]>=0)
     close(h->to_gdb[0]);
  if (h->to)
@@ -129,6 +169,12 @@ void mi_free_h(mi_h **handle)
     free(h->line);
  mi_free_output(h->po);
  free(h->catched_console);
+ free(h->catched_result);
+ mi_free_eval_cache(h->eval_cache);
+ mi_free_output(h->async_po);
+ mi_enable_hit_stats(h,0);
+ free(h->thr_states);
+ free(h->thr_index);
  free(h);
  *handle=NULL;
 }
@@ -174,6 +220,190 @@ int mi_getline(mi_h *h)
  return 0;
 }
 
+/* Per thread run state, indexed by id using open addressing. */
+
+static
+int mi_thr_slot(mi_h *h, int id)
+{
+ unsigned mask=h->thr_buckets-1;
+ unsigned i=((unsigned)id*2654435761u) & mask;
+
+ while (h->thr_index[i]>=0 && h->thr_states[h->thr_index[i]].id!=id)
+    i=(i+1) & mask;
+ return i;
+}
+
+static
+int mi_thr_rehash(mi_h *h, int buckets)
+{
+ int i, *n=h->thr_index;
+
+ if (buckets!=h->thr_buckets)
+   {
+    n=(int *)malloc(buckets*sizeof(int));
+    if (!n)
+       return 0;
+    free(h->thr_index);
+    h->thr_index=n;
+    h->thr_buckets=buckets;
+   }
+ for (i=0; i<buckets; i++)
+     n[i]=-1;
+ for (i=0; i<h->nthr_states; i++)
+     n[mi_thr_slot(h,h->thr_states[i].id)]=i;
+ return 1;
+}
+
+static
+mi_thread_state *mi_thr_find(mi_h *h, int id, int add)
+{
+ int i;
+ mi_thread_state *t;
+
+ if (h->thr_buckets)
+   {
+    i=mi_thr_slot(h,id);
+    if (h->thr_index[i]>=0)
+       return h->thr_states+h->thr_index[i];
+   }
+ if (!add)
+    return NULL;
+ if (h->nthr_states>=h->athr_states)
+   {
+    int n=h->athr_states ? h->athr_states*2 : 16;
+    t=(mi_thread_state *)realloc(h->thr_states,n*sizeof(mi_thread_state));
+    if (!t)
+       return NULL;
+    h->thr_states=t;
+    h->athr_states=n;
+   }
+ /* Keep the load under 50%. */
+ if ((h->nthr_states+1)*2>h->thr_buckets &&
+     !mi_thr_rehash(h,h->thr_buckets ? h->thr_buckets*2 : 32))
+    return NULL;
+ h->thr_index[mi_thr_slot(h,id)]=h->nthr_states;
+ t=h->thr_states+h->nthr_states++;
+ t->id=id;
+ t->running=0;
+ return t;
+}
+
+static
+void mi_thr_set(mi_h *h, const char *id, char running)
+{
+ mi_thread_state *t;
+ int i;
+
+ if (strcmp(id,"all")==0)
+   {
+    for (i=0; i<h->nthr_states; i++)
+        h->thr_states[i].running=running;
+    return;
+   }
+ t=mi_thr_find(h,atoi(id),1);
+ if (t)
+    t->running=running;
+}
+
+static
+void mi_update_thread_states(mi_h *h, mi_output *o)
+{
+ mi_results *r, *c;
+ mi_thread_state *t;
+
+ if (o->type!=MI_T_OUT_OF_BAND || o->stype!=MI_ST_ASYNC)
+    return;
+ switch (o->tclass)
+   {
+    case MI_CL_RUNNING:
+         r=mi_get_var(o,"thread-id");
+         mi_thr_set(h,r && r->type==t_const ? r->v.cstr : "all",1);
+         break;
+    case MI_CL_STOPPED:
+         /* Without this list all the threads are stopped (all-stop). */
+         r=mi_get_var(o,"stopped-threads");
+         if (r && r->type==t_list)
+           {
+            for (c=r->v.rs; c; c=c->next)
+                if (c->type==t_const)
+                   mi_thr_set(h,c->v.cstr,0);
+           }
+         else
+            mi_thr_set(h,r && r->type==t_const ? r->v.cstr : "all",0);
+         break;
+    case MI_CL_THREAD_CREATED:
+         r=mi_get_var(o,"id");
+         if (r && r->type==t_const)
+           {
+            t=mi_thr_find(h,atoi(r->v.cstr),1);
+            if (t)
+               t->running=1;
+           }
+         break;
+    case MI_CL_THREAD_EXITED:
+         r=mi_get_var(o,"id");
+         if (r && r->type==t_const)
+           {
+            t=mi_thr_find(h,atoi(r->v.cstr),0);
+            if (t)
+              {/* Rare, just rebuild the index. */
+               *t=h->thr_states[--h->nthr_states];
+               mi_thr_rehash(h,h->thr_buckets);
+              }
+           }
+         break;
+   }
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Returns the run state of a thread. The state is updated using the
+*running, *stopped, =thread-created and =thread-exited records, so it's
+useful in non-stop mode. @x{gmi_thread_info} also updates it.
+
+  Return: 1 if running, 0 if stopped and -1 if unknown.
+
+***************************************************************************/
+
+int mi_get_thread_state(mi_h *h, int id)
+{
+ mi_thread_state *t=mi_thr_find(h,id,0);
+ return t ? t->running : -1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the table of known threads and their run state. The table belongs
+to the handle and changes as the records from gdb are processed.
+
+  Return: The table, @var{count} is filled with the number of entries.
+
+***************************************************************************/
+
+const mi_thread_state *mi_get_thread_states(mi_h *h, int *count)
+{
+ *count=h->nthr_states;
+ return h->thr_states;
+}
+
+/* Replaces the table using the information from -thread-info. */
+void mi_set_thread_states(mi_h *h, mi_thread *l)
+{
+ mi_thread_state *t;
+
+ h->nthr_states=0;
+ if (h->thr_buckets)
+    mi_thr_rehash(h,h->thr_buckets);
+ for (; l; l=l->next)
+    {
+     t=mi_thr_find(h,l->id,1);
+     if (t)
+        t->running=l->running;
+    }
+}
+
 char *get_cstr(mi_output *o)
 {
  if (!o->c || o->c->type!=t_const)
@@ -183,24 +413,56 @@ char *get_cstr(mi_output *o)
 
 int mi_get_response(mi_h *h)
 {
- int l=mi_getline(h);
+ mi_output *o=NULL;
+ int l;
+
+ /* The reader thread could have parsed it already. */
+ if (h->reader)
+    l=mi_reader_get(h,&o);
+ else
+    l=mi_getline(h);
  if (!l)
     return 0;
 
- if (h->from_gdb_echo)
+ if (h->from_gdb_echo && (!o || l==1))
     h->from_gdb_echo(h->line,h->from_gdb_echo_data);
- if (strncmp(h->line,"(gdb)",5)==0)
+ if (!o && strncmp(h->line,"(gdb)",5)==0)
    {/* End of response. */
     return 1;
    }
  else
    {/* Add to the response. */
-    mi_output *o;
+    mi_event *e;
     int add=1, is_exit=0;
-    o=mi_parse_gdb_output(h->line);
+    if (!o)
+      {
+       /* Unwanted notifications are discarded without parsing them. */
+       if (h->line[0]=='=' && !mi_want_notify(h,h->line+1))
+          return 0;
+       if (h->catch_result && strncmp(h->line,"^done,",6)==0)
+         {/* The caller will parse it, just keep the line. We swap the
+             buffers so we don't need to allocate memory. */
+          char *aux=h->catched_result;
+          int len=h->catched_result_size;
+          h->catch_result--;
+          h->catched_result=h->line;
+          h->catched_result_size=h->llen;
+          h->line=aux;
+          h->llen=len;
+          o=mi_alloc_output();
+          if (o)
+            {
+             o->type=MI_T_RESULT_RECORD;
+             o->tclass=MI_CL_DONE;
+            }
+         }
+       else
+          o=mi_parse_gdb_output(h->line);
+      }
 
     if (!o)
        return 0;
+    mi_update_thread_states(h,o);
     /* Tunneled streams callbacks. */
     if (o->type==MI_T_OUT_OF_BAND && o->stype==MI_ST_STREAM)
       {
@@ -237,6 +499,16 @@ int mi_get_response(mi_h *h)
       {
        if (h->async)
           h->async(o,h->async_data);
+       if (h->event && o->sstype==MI_SST_NOTIFY)
+         {
+          e=mi_get_event(o);
+          if (e)
+            {/* Consumed, the strings were moved to the event. */
+             h->event(e,h->event_data);
+             mi_free_event(e);
+             add=0;
+            }
+         }
       }
     else if (o->type==MI_T_RESULT_RECORD && o->tclass==MI_CL_ERROR)
       {/* Error from gdb, record it. */
@@ -246,6 +518,13 @@ int mi_get_response(mi_h *h)
        if (o->c && strcmp(o->c->var,"msg")==0 && o->c->type==t_const)
           mi_error_from_gdb=strdup(o->c->v.cstr);
       }
+    if (h->hit_stats)
+       mi_hit_stats_record(h,o);
+    /* The target resumed or stopped, what we know about it is old. */
+    if ((o->type==MI_T_RESULT_RECORD && o->tclass==MI_CL_RUNNING) ||
+        (o->type==MI_T_OUT_OF_BAND && o->stype==MI_ST_ASYNC &&
+         (o->tclass==MI_CL_STOPPED || o->tclass==MI_CL_RUNNING)))
+       h->stop_gen++;
     is_exit=(o->type==MI_T_RESULT_RECORD && o->tclass==MI_CL_EXIT);
     /* Add to the list of responses. */
     if (add)
@@ -273,7 +552,95 @@ mi_output *mi_retire_response(mi_h *h)
  return ret;
 }
 
-mi_output *mi_get_response_blk(mi_h *h)
+/* Moves the current response to the list of kept async records. */
+static
+void mi_keep_async(mi_h *h)
+{
+ if (!h->po)
+    return;
+ if (h->async_last)
+    h->async_last->next=h->po;
+ else
+    h->async_po=h->po;
+ h->async_last=h->last;
+ h->po=h->last=NULL;
+}
+
+/* Moves the stop records mixed with a result to the kept records. */
+static
+void mi_keep_stops(mi_h *h)
+{
+ mi_output *o=h->po, *prev=NULL, *next;
+
+ for (; o; o=next)
+    {
+     next=o->next;
+     if (o->type==MI_T_OUT_OF_BAND && o->stype==MI_ST_ASYNC &&
+         o->tclass==MI_CL_STOPPED)
+       {
+        if (prev)
+           prev->next=next;
+        else
+           h->po=next;
+        if (h->last==o)
+           h->last=prev;
+        o->next=NULL;
+        if (h->async_last)
+           h->async_last->next=o;
+        else
+           h->async_po=o;
+        h->async_last=o;
+       }
+     else
+        prev=o;
+    }
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  In non-stop mode gdb can report a stop while we are waiting for the
+result of a command. These async records are kept and this function moves
+them to the current response, so they can be obtained using
+@x{mi_retire_response} (i.e. @x{mi_res_stop}). Only the records up to the
+first *stopped are moved, so each call hands back one stop and the stops
+from other threads aren't lost.
+
+  Return: !=0 if there were kept records.
+
+***************************************************************************/
+
+int mi_get_kept_async(mi_h *h)
+{
+ mi_output *first=h->async_po, *last;
+
+ if (!first)
+    return 0;
+ for (last=first; last->next; last=last->next)
+     if (last->type==MI_T_OUT_OF_BAND && last->stype==MI_ST_ASYNC &&
+         last->tclass==MI_CL_STOPPED)
+        break;
+ h->async_po=last->next;
+ if (!h->async_po)
+    h->async_last=NULL;
+ last->next=NULL;
+ if (h->last)
+   {/* Keep the order. */
+    last->next=h->po;
+    h->po=first;
+   }
+ else
+   {
+    h->po=first;
+    h->last=last;
+   }
+ return 1;
+}
+
+/* Waits for a response. In non-stop mode the async records are kept
+   until a result arrives, unless stop is !=0 and they contain a stop. */
+static
+mi_output *mi_wait_response(mi_h *h, int stop)
 {
  int r;
  /* Sometimes gdb dies. */
@@ -299,11 +666,26 @@ mi_output *mi_get_response_blk(mi_h *h)
        int ret;
 
        r=mi_get_response(h);
+       if (r && h->non_stop && !mi_get_rrecord(h->po) &&
+           !(stop && mi_get_stop_record(h->po)))
+         {/* Just async records, the result will come later. */
+          mi_keep_async(h);
+          r=0;
+          continue;
+         }
+       if (r && h->non_stop && mi_get_rrecord(h->po))
+          mi_keep_stops(h);
        if (r)
           return mi_retire_response(h);
+       if (h->reader && mi_reader_eof(h))
+         {/* The reader found that gdb closed the pipe. */
+          h->died=1;
+          mi_error=MI_GDB_DIED;
+          return NULL;
+         }
 
        FD_ZERO(&set);
-       FD_SET(h->from_gdb[0],&set);
+       FD_SET(mi_get_read_fd(h),&set);
        timeout.tv_sec=h->time_out;
        timeout.tv_usec=0;
        ret=TEMP_FAILURE_RETRY(select(FD_SETSIZE,&set,NULL,NULL,&timeout));
@@ -338,6 +720,40 @@ mi_output *mi_get_response_blk(mi_h *h)
  return NULL;
 }
 
+mi_output *mi_get_response_blk(mi_h *h)
+{
+ return mi_wait_response(h,0);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Blocks until a *stopped record is received. The stops kept while waiting
+for other responses are used first (see @x{mi_get_kept_async}), other
+responses are discarded. Use it instead of @x{mi_get_response_blk} to wait
+for the target, in non-stop mode a lone *stopped isn't a response.
+
+  Return: The response containing the stop (see @x{mi_get_stop_record}) or
+NULL on error.
+
+***************************************************************************/
+
+mi_output *mi_get_stop_blk(mi_h *h)
+{
+ mi_output *o;
+
+ for (;;)
+    {
+     if (mi_get_kept_async(h))
+        o=mi_retire_response(h);
+     else
+        o=mi_wait_response(h,1);
+     if (!o || mi_get_stop_record(o))
+        return o;
+     mi_free_output(o);
+    }
+}
+
 void mi_send_commands(mi_h *h, const char *file)
 {
  FILE *f;
@@ -394,6 +810,7 @@ mi_h *mi_connect_local()
  if (!h)
     return h;
  h->time_out=MI_DEFAULT_TIME_OUT;
+ h->pipeline_depth=MI_DEFAULT_PIPELINE_DEPTH;
  /* Create the pipes to connect with the child. */
  if (pipe(h->to_gdb) || pipe(h->from_gdb))
    {
@@ -517,6 +934,52 @@ async_cb mi_get_async_cb(mi_h *h, void **data)
  return h->async;
 }
 
+/**[txh]********************************************************************
+
+  Description:
+  Sets the callback for the =notify records. They are decoded to a
+mi_event (see @x{mi_get_event}), valid only during the call. The decoded
+records aren't added to the response. Only the classes selected with
+@x{mi_set_notify_mask} are reported.
+
+***************************************************************************/
+
+void mi_set_event_cb(mi_h *h, event_cb cb, void *data)
+{
+ h->event=cb;
+ h->event_data=data;
+}
+
+event_cb mi_get_event_cb(mi_h *h, void **data)
+{
+ if (data)
+    *data=h->event_data;
+ return h->event;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Selects the =notify records we want, the rest are discarded before
+parsing them. The @var{mask} is a combination of MI_EV_MASK(MI_CL_*)
+values, the default is MI_EV_DEFAULT: the records handled by old versions
+of the library. The library, thread group, breakpoint, etc. notifications
+are discarded unless they are included here, i.e. MI_EV_ALL. Unknown
+notifications are only kept if MI_EV_MASK(MI_CL_UNKNOWN) is included. In non-stop mode the thread
+created/exited records are always processed.
+
+***************************************************************************/
+
+void mi_set_notify_mask(mi_h *h, unsigned mask)
+{
+ __atomic_store_n(&h->notify_mask,mask,__ATOMIC_RELAXED);
+}
+
+unsigned mi_get_notify_mask(mi_h *h)
+{
+ return h->notify_mask;
+}
+
 void mi_set_to_gdb_cb(mi_h *h, stream_cb cb, void *data)
 {
  h->to_gdb_echo=cb;
@@ -525,7 +988,8 @@ void mi_set_to_gdb_cb(mi_h *h, stream_cb cb, void *data)
 
 void mi_set_from_gdb_cb(mi_h *h, stream_cb cb, void *data)
 {
- h->from_gdb_echo=cb;
+ /* The reader thread checks it. */
+ __atomic_store_n(&h->from_gdb_echo,cb,__ATOMIC_RELAXED);
  h->from_gdb_echo_data=data;
 }
 
@@ -566,6 +1030,53 @@ int mi_get_time_out(mi_h *h)
  return h->time_out;
 }
 
+void mi_set_pipeline_depth(mi_h *h, int depth)
+{
+ h->pipeline_depth=depth>0 ? depth : 1;
+}
+
+int mi_get_pipeline_depth(mi_h *h)
+{
+ return h->pipeline_depth;
+}
+
+unsigned mi_get_stop_gen(mi_h *h)
+{
+ return h->stop_gen;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Discards the information cached for the current stop. The caches are
+automatically discarded when the target resumes or stops, but if you modify
+the target state by other means (i.e. assigning a value using
+@x{gmi_data_evaluate_expression}) you must call it.
+
+***************************************************************************/
+
+void mi_invalidate_caches(mi_h *h)
+{
+ h->stop_gen++;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Informs that the selected frame, or the thread if @var{thread} is !=0,
+changed. The target state is the same, so only the cached information
+that refers to the current thread or frame is discarded. Called by
+@x{gmi_stack_select_frame} and @x{gmi_thread_select}.
+
+***************************************************************************/
+
+void mi_selection_changed(mi_h *h, int thread)
+{
+ h->sel_gen++;
+ if (thread)
+    h->thread_gen++;
+}
+
 int mi_send(mi_h *h, const char *format, ...)
 {
  int ret;
@@ -587,6 +1098,43 @@ int mi_send(mi_h *h, const char *format, ...)
  return ret;
 }
 
+/**[txh]********************************************************************
+
+  Description:
+  Sends @var{count} commands to gdb without waiting for the response of each
+one. The @var{snd} callback must send the command number @var{index} and
+@var{rcv} must collect its response, usually using one of the mi_res_*
+functions. gdb answers the commands in the same order they were sent, so
+we just keep at most @x{mi_set_pipeline_depth} of them waiting for a
+response. This avoids filling the pipes, gdb stops reading when it can't
+write. If gdb dies or doesn't answer we stop sending commands, the dialog
+is lost anyways.
+
+  Return: The number of commands that @var{rcv} reported as successful or
+-1 if gdb died or the response timed out.
+
+***************************************************************************/
+
+int mi_pipeline(mi_h *h, int count, mi_pl_send_cb snd, mi_pl_recv_cb rcv,
+                void *data)
+{
+ int sent=0, done=0, ok=0;
+ int depth=h->pipeline_depth>0 ? h->pipeline_depth : 1;
+
+ while (done<count)
+   {
+    while (sent<count && sent-done<depth)
+       snd(h,sent++,data);
+    mi_error=MI_OK;
+    if (rcv(h,done,data))
+       ok++;
+    else if (mi_error==MI_GDB_DIED || mi_error==MI_GDB_TIME_OUT)
+       return -1;
+    done++;
+   }
+ return ok;
+}
+
 void mi_clean_up_globals()
 {
  free(gdb_exe);
@@ -599,6 +1147,7 @@ void mi_clean_up_globals()
  gdb_conn=NULL;
  free(main_func);
  main_func=NULL;
+ mi_reg_names_flush();
 }
 
 void mi_register_exit()
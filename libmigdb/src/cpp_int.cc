@@ -43,6 +43,11 @@ MIDebugger::MIDebugger()
  waitingTempBkpt=0;
  targetEndian=enUnknown;
  targetArch=arUnknown;
+ archKey=NULL;
+ regsKey=NULL;
+ snap=NULL;
+ snapWhat=0;
+ snapFmt=fm_natural;
 }
 
 /**[txh]********************************************************************
@@ -77,6 +82,9 @@ MIDebugger::~MIDebugger()
  if (state==connected)
     Disconnect();
  // Here state==disconnected
+ free(archKey);
+ free(regsKey);
+ mi_free_snapshot(snap);
 }
 
 /**[txh]********************************************************************
@@ -148,6 +156,10 @@ int MIDebugger::SelectTargetTTY(const char *exec, const char *args,
 
  targetEndian=enUnknown;
  targetArch=arUnknown;
+ free(archKey);
+ archKey=NULL;
+ free(regsKey);
+ regsKey=NULL;
  mode=m;
  if (!gmi_set_exec(h,exec,args))
     return 0;
@@ -251,6 +263,10 @@ int MIDebugger::SelectTargetRemote(const char *exec, const char *rparams,
  preRun=true;
  targetEndian=enUnknown;
  targetArch=arUnknown;
+ free(archKey);
+ archKey=NULL;
+ free(regsKey);
+ regsKey=NULL;
  if (rtype==NULL)
     rtype="extended-remote";
 
@@ -290,6 +306,10 @@ mi_frames *MIDebugger::SelectTargetPID(const char *exec, int pid)
  preRun=false;
  targetEndian=enUnknown;
  targetArch=arUnknown;
+ free(archKey);
+ archKey=NULL;
+ free(regsKey);
+ regsKey=NULL;
 
  mi_frames *res=gmi_target_attach(h,pid);
  if (res)
@@ -411,7 +431,10 @@ mi_stop structure if we got it or will be NULL if we didn't.
 
 int MIDebugger::Poll(mi_stop *&rs)
 {
- if (state==disconnected || !mi_get_response(h))
+ if (state==disconnected)
+    return 0;
+ // In non-stop mode the stops can arrive while waiting for a command.
+ if (!mi_get_kept_async(h) && !mi_get_response(h))
     return 0;
 
  mi_stop *res=mi_res_stop(h);
@@ -425,11 +448,19 @@ int MIDebugger::Poll(mi_stop *&rs)
        state=mode==dmPID ? connected : target_specified;
     else
        state=stopped;
+    if (h->non_stop && state==stopped)
+       UpdateNonStopState();
     if (res->reason==sr_unknown && waitingTempBkpt)
       {
        waitingTempBkpt=0;
        res->reason=sr_bkpt_hit;
       }
+    // Get all the information the front-end will need in one round trip.
+    if (state==stopped && snapWhat)
+      {
+       mi_free_snapshot(snap);
+       snap=gmi_snapshot(h,snapWhat,snapFmt);
+      }
    }
  else
    {// We got an error. It looks like most async commands returns running even
@@ -438,13 +469,98 @@ int MIDebugger::Poll(mi_stop *&rs)
     // Lamentably -target-exec-status isn't implemented and even in this case
     // if the program is really running as real async isn't implemented it
     // will fail anyways.
-    if (state==running)
+    if (h->non_stop)
+       // Here we also get the thread notifications.
+       UpdateNonStopState();
+    else if (state==running)
        state=stopped;
    }
  rs=res;
  return 1;
 }
 
+/**[txh]********************************************************************
+
+  Description:
+  Enables the non-stop mode, each thread can be stopped and resumed
+independently. Can be called when the state is "connected" or
+"target_specified", before running the program. When at least one thread
+is stopped the state is "stopped", otherwise is "running". See
+@x{gmi_set_non_stop}.
+
+  Return: !=0 OK
+
+***************************************************************************/
+
+int MIDebugger::EnableNonStop()
+{
+ if (state!=connected && state!=target_specified)
+    return 0;
+ return gmi_set_non_stop(h,1);
+}
+
+/* Computes the state from the run state of the threads. */
+void MIDebugger::UpdateNonStopState()
+{
+ int i, count;
+ const mi_thread_state *t=mi_get_thread_states(h,&count);
+
+ if (state!=running && state!=stopped)
+    return;
+ for (i=0; i<count; i++)
+     if (!t[i].running)
+       {
+        state=stopped;
+        return;
+       }
+ if (count)
+    state=running;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Executes @var{cmd} only for @var{thread} (MI_ALL_THREADS for all). Only
+for the non-stop mode. Can be called when the state is "running" or
+"stopped", the state is updated from the threads run state.
+
+  Return: !=0 OK
+
+***************************************************************************/
+
+int MIDebugger::ThreadExec(int (*cmd)(mi_h *, int), int thread)
+{
+ if (!h->non_stop || (state!=running && state!=stopped))
+    return 0;
+ int res=cmd(h,thread);
+ if (res)
+    UpdateNonStopState();
+ return res;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets a snapshot of the stopped program: current frame, arguments, locals,
+registers and threads. If @x{::SetAutoSnapshot} was used the snapshot is
+taken by @x{::Poll} as soon as the program stops, otherwise is taken now,
+requesting all the parts. See @x{gmi_snapshot}.
+
+  Return: The snapshot, owned by the object, or NULL if not stopped.
+
+***************************************************************************/
+
+const mi_snapshot *MIDebugger::GetSnapshot()
+{
+ if (state!=stopped)
+    return NULL;
+ if (snap && snap->stop_gen==mi_get_stop_gen(h))
+    return snap;
+ mi_free_snapshot(snap);
+ snap=gmi_snapshot(h,snapWhat ? snapWhat : MI_SNAP_ALL,snapFmt);
+ return snap;
+}
+
 /**[txh]********************************************************************
 
   Description:
@@ -692,6 +808,30 @@ int MIDebugger::RunToMain()
  return Run();
 }
 
+/**[txh]********************************************************************
+
+  Description:
+  Samples the stacks of the running program @var{samples} times, one every
+@var{interval} milliseconds. See @x{gmi_profile_run}. Can be called when
+the state is "running", the state changes if the program exits or if it
+couldn't be resumed.
+
+  Return: The number of samples taken or -1 if not running.
+
+***************************************************************************/
+
+int MIDebugger::Profile(mi_profile *p, int samples, int interval)
+{
+ if (state!=running)
+    return -1;
+ int n=gmi_profile_run(h,p,samples,interval);
+ if (p->exited)
+    state=mode==dmPID ? connected : target_specified;
+ else if (p->stopped)
+    state=stopped;
+ return n;
+}
+
 /**[txh]********************************************************************
 
   Description:
@@ -930,6 +1070,40 @@ char *MIDebugger::EvalExpression(const char *exp)
  return res;
 }
 
+/**[txh]********************************************************************
+
+  Description:
+  Evaluates a group of expressions, i.e. the contents of a watch window.
+The expressions are sent to gdb using a pipeline and the results are cached
+until the program is resumed. If an expression can't be evaluated the error
+description is returned instead. Use -1 for @var{thread} and @var{frame} to
+use the current ones. Can't be called if "disconnected" or "running".
+  
+  Return: The number of expressions evaluated. The results are stored in
+@var{values} (use free), NULL when we don't even have an error message.
+  
+***************************************************************************/
+
+int MIDebugger::EvalExpressions(int count, const char **exps, char **values,
+                                int thread, int frame)
+{
+ if (state==disconnected ||
+     state==running) // No async :-(
+    return 0;
+ char **errors=(char **)mi_calloc(count ? count : 1,sizeof(char *));
+ if (!errors)
+    return 0;
+ int res=gmi_data_evaluate_expressions(h,count,exps,thread,frame,values,
+                                       errors);
+ for (int i=0; i<count; i++)
+     if (!values[i])
+        values[i]=errors[i]; // Not valid, return the error
+     else
+        free(errors[i]);
+ free(errors);
+ return res<0 ? 0 : res;
+}
+
 /**[txh]********************************************************************
 
   Description:
@@ -955,6 +1129,8 @@ char *MIDebugger::ModifyExpression(char *exp, char *newVal)
  *s='=';
  memcpy(++s,newVal,l2);
  s[l2]=0;
+ // The cached values are no longer valid
+ mi_invalidate_caches(h);
  // Evaluate it
  char *res=gmi_data_evaluate_expression(h,b);
  if (!res && mi_error_from_gdb)
@@ -1072,29 +1248,181 @@ MIDebugger::endianType MIDebugger::GetTargetEndian()
  return targetEndian;
 }
 
+/**[txh]********************************************************************
+
+  Description:
+  Returns a string that identifies the target architecture. It's the name
+reported by "show architecture". Used to select architecture dependent
+tables, i.e. the hardware watchpoints limits. The registers also depend on
+the target description, so the register names cache uses
+@x{::GetRegNamesKey}.
+
+  Return: The key or NULL if unknown. Owned by the object.
+
+***************************************************************************/
+
+const char *MIDebugger::GetArchKey()
+{
+ if (archKey)
+    return archKey;
+ if (state!=stopped && state!=target_specified)
+    return NULL;
+
+ char *end=Show("architecture");
+ if (!end)
+    return NULL;
+ // "set automatically (currently i386:x86-64)", newer gdbs quote it.
+ // Otherwise: "is assumed to be i386" or "set to \"avr\"".
+ const char *s=strstr(end,"(currently ");
+ if (s)
+    s+=11;
+ else if ((s=strstr(end,"assumed to be "))!=NULL)
+    s+=14;
+ else if ((s=strstr(end,"set to "))!=NULL)
+    s+=7;
+ else
+    s=end;
+ if (*s=='"')
+    s++;
+ int l=strcspn(s,"\"). \t\n");
+ archKey=(char *)mi_malloc(l+1);
+ if (archKey)
+   {
+    memcpy(archKey,s,l);
+    archKey[l]=0;
+   }
+ free(end);
+ return archKey;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Returns the key used for the register names cache (@x{gmi_reg_names_get}).
+It's the architecture (@x{::GetArchKey}) plus the target description file,
+if one was specified. Remote stubs send their own target description, two
+of them can report different registers for the same architecture, so the
+names of remote targets aren't shared.
+
+  Return: The key or NULL if the names can't be shared. Owned by the
+object.
+
+***************************************************************************/
+
+const char *MIDebugger::GetRegNamesKey()
+{
+ if (regsKey)
+    return regsKey;
+ if (mode==dmRemote)
+    return NULL;
+ const char *arch=GetArchKey();
+ if (!arch)
+    return NULL;
+
+ // "The target description will be read from the target." if not set.
+ char *tdesc=Show("tdesc filename");
+ const char *s=tdesc && !strstr(tdesc,"from the target") ? tdesc : "";
+ const char *q=strchr(s,'"');
+ int l;
+ if (q)
+   {// Console message, the name is quoted.
+    s=q+1;
+    l=strcspn(s,"\"");
+   }
+ else
+    l=strcspn(s,"\n");
+ regsKey=(char *)mi_malloc(strlen(arch)+l+2);
+ if (regsKey)
+   {
+    strcpy(regsKey,arch);
+    if (l)
+      {
+       strcat(regsKey,"/");
+       strncat(regsKey,s,l);
+      }
+   }
+ free(tdesc);
+ return regsKey;
+}
+
 MIDebugger::archType MIDebugger::GetTargetArchitecture()
 {
  if (targetArch!=arUnknown)
     return targetArch;
- if (state!=stopped && state!=target_specified)
-    return arUnknown;
 
- char *end=Show("architecture");
- if (end)
+ const char *arch=GetArchKey();
+ if (arch)
    {
-    if (strstr(end,"i386"))
+    if (strstr(arch,"i386"))
        targetArch=arIA32;
-    else if (strstr(end,"sparc"))
+    else if (strstr(arch,"sparc"))
        targetArch=arSPARC;
-    else if (strstr(end,"pic14"))
+    else if (strstr(arch,"pic14"))
        targetArch=arPIC14;
-    else if (strstr(end,"avr"))
+    else if (strstr(arch,"avr"))
        targetArch=arAVR;
-    free(end);
    }
  return targetArch;
 }
 
+/**[txh]********************************************************************
+
+  Description:
+  Gets the list of register names. The names are taken from the shared
+cache (see @x{::GetRegNamesKey}), so only the first session for an
+architecture asks gdb.
+
+  Return: A new list or NULL on error, @var{how_many} is filled with the
+number of registers.
+
+***************************************************************************/
+
+mi_chg_reg *MIDebugger::GetRegisterNames(int *how_many)
+{
+ if (state!=target_specified && state!=stopped)
+    return NULL;
+ mi_reg_names *rn=gmi_reg_names_get(h,GetRegNamesKey());
+ if (!rn)
+    return NULL;
+ mi_chg_reg *l=mi_reg_names_to_chg_reg(rn,how_many);
+ mi_reg_names_release(rn);
+ return l;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Fills the names of the registers in the @var{chg} list using the shared
+cache.
+
+  Return: !=0 OK.
+
+***************************************************************************/
+
+int MIDebugger::GetRegisterNames(mi_chg_reg *chg)
+{
+ if (state!=target_specified && state!=stopped)
+    return 0;
+ mi_reg_names *rn=gmi_reg_names_get(h,GetRegNamesKey());
+ if (!rn)
+    return 0;
+ int ok=1;
+ for (; chg; chg=chg->next)
+    {
+     if (chg->reg<0 || chg->reg>=rn->count)
+       {
+        mi_error=MI_PARSER;
+        ok=0;
+        break;
+       }
+     const char *name=rn->names[chg->reg];
+     free(chg->name);
+     chg->name=strdup(name ? name : "");
+    }
+ mi_reg_names_release(rn);
+ return ok;
+}
+
 int MIDebugger::GetErrorNumberSt()
 {
  if (mi_error==MI_GDB_DIED)
@@ -1107,18 +1435,41 @@ int MIDebugger::GetErrorNumberSt()
  return mi_error;
 }
 
+/**[txh]********************************************************************
+
+  Description:
+  Updates the values of the @var{regs} list using the registers that
+changed. The updated field indicates which ones changed. Consider using a
+register file (@x{::CreateRegFile}) instead.
+
+  Return: The number of updated registers.
+
+***************************************************************************/
+
 int MIDebugger::UpdateRegisters(mi_chg_reg *regs)
 {
  int updated=0;
  mi_chg_reg *chg=GetChangedRegisters();
  if (chg)
    {
-    mi_chg_reg *r=regs, *c;
-    while (r)
+    mi_chg_reg *r, *c;
+    // Index the changed registers by number, avoids a nested search
+    int max=-1;
+    for (c=chg; c; c=c->next)
+        if (c->reg>max)
+           max=c->reg;
+    mi_chg_reg **idx=(mi_chg_reg **)mi_calloc(max+1,sizeof(mi_chg_reg *));
+    if (!idx)
+      {
+       mi_free_chg_reg(chg);
+       return 0;
+      }
+    for (c=chg; c; c=c->next)
+        if (c->reg>=0)
+           idx[c->reg]=c;
+    for (r=regs; r; r=r->next)
       {
-       c=chg;
-       while (c && c->reg!=r->reg)
-          c=c->next;
+       c=r->reg>=0 && r->reg<=max ? idx[r->reg] : NULL;
        if (c)
          {
           r->updated=1;
@@ -1129,8 +1480,9 @@ int MIDebugger::UpdateRegisters(mi_chg_reg *regs)
          }
        else
           r->updated=0;
-       r=r->next;
       }
+    free(idx);
+    mi_free_chg_reg(chg);
    }
  return updated;
 }
@@ -25,7 +25,7 @@
 gdb command:                       Implemented?
 
 -data-disassemble                  Yes
--data-evaluate-expression          Yes
+-data-evaluate-expression          Yes (also pipelined and cached)
 -data-list-changed-registers       No
 -data-list-register-names          Yes
 -data-list-register-values         No
@@ -86,8 +86,33 @@ Fixed by Changelog entry:
 
 ***************************************************************************/
 
+#include <string.h>
 #include "mi_gdb.h"
 
+/* Cache for the evaluated expressions. All the entries belong to the same
+   stop, when the stop generation changes we discard all of them. */
+typedef struct mi_eval_entry_struct
+{
+ char *exp;
+ int thread, frame;
+ unsigned hash;
+ /* 0 not yet known, 1 value, 2 error message. */
+ int state;
+ char *value;
+ struct mi_eval_entry_struct *next;
+} mi_eval_entry;
+
+struct mi_eval_cache_struct
+{
+ unsigned stop_gen;
+ unsigned sel_gen;
+ int buckets; /* Power of 2 */
+ int count;
+ mi_eval_entry **table;
+};
+
+#define MI_EVAL_CACHE_BUCKETS 64
+
 /* Low level versions. */
 
 void mi_data_evaluate_expression(mi_h *h, const char *expression)
@@ -95,6 +120,25 @@ void mi_data_evaluate_expression(mi_h *h, const char *expression)
  mi_send(h,"-data-evaluate-expression \"%s\"\n",expression);
 }
 
+void mi_data_evaluate_expression_tf(mi_h *h, const char *expression,
+                                    int thread, int frame)
+{
+ char s_thread[32];
+ char s_frame[32];
+
+ if (thread<0 && frame<0)
+   {
+    mi_data_evaluate_expression(h,expression);
+    return;
+   }
+ if (thread>=0)
+    snprintf(s_thread,32,"--thread %d",thread);
+ if (frame>=0)
+    snprintf(s_frame,32,"--frame %d",frame);
+ mi_send(h,"-data-evaluate-expression %s %s \"%s\"\n",
+         thread>=0 ? s_thread : "",frame>=0 ? s_frame : "",expression);
+}
+
 void mi_dir(mi_h *h, const char *path)
 {
  if (h->version>=MI_VERSION2U(2,0,0))
@@ -182,6 +226,282 @@ char *gmi_data_evaluate_expression(mi_h *h, const char *expression)
  return mi_res_value(h);
 }
 
+static
+unsigned mi_eval_hash(const char *exp, int thread, int frame)
+{
+ unsigned hash=2166136261u;
+
+ for (; *exp; exp++)
+    {
+     hash^=(unsigned char)*exp;
+     hash*=16777619u;
+    }
+ hash^=(unsigned)thread*31+(unsigned)frame;
+ return hash*16777619u;
+}
+
+static
+void mi_eval_cache_clear(mi_eval_cache *c)
+{
+ int i;
+ mi_eval_entry *e, *aux;
+
+ for (i=0; i<c->buckets; i++)
+    {
+     for (e=c->table[i]; e; e=aux)
+        {
+         aux=e->next;
+         free(e->exp);
+         free(e->value);
+         free(e);
+        }
+     c->table[i]=NULL;
+    }
+ c->count=0;
+}
+
+/* Drops the entries for the current thread or frame (-1), used when the
+   selection changes. */
+static
+void mi_eval_cache_drop_current(mi_eval_cache *c)
+{
+ int i;
+ mi_eval_entry **p, *e;
+
+ for (i=0; i<c->buckets; i++)
+     for (p=c->table+i; (e=*p)!=NULL; )
+         if (e->thread<0 || e->frame<0)
+           {
+            *p=e->next;
+            free(e->exp);
+            free(e->value);
+            free(e);
+            c->count--;
+           }
+         else
+            p=&e->next;
+}
+
+void mi_free_eval_cache(mi_eval_cache *c)
+{
+ if (!c)
+    return;
+ mi_eval_cache_clear(c);
+ free(c->table);
+ free(c);
+}
+
+/* Returns the cache for the current stop, creating it if needed. */
+static
+mi_eval_cache *mi_get_eval_cache(mi_h *h)
+{
+ mi_eval_cache *c=h->eval_cache;
+
+ if (!c)
+   {
+    c=(mi_eval_cache *)mi_calloc1(sizeof(mi_eval_cache));
+    if (!c)
+       return NULL;
+    c->buckets=MI_EVAL_CACHE_BUCKETS;
+    c->table=(mi_eval_entry **)mi_calloc(c->buckets,sizeof(mi_eval_entry *));
+    if (!c->table)
+      {
+       free(c);
+       return NULL;
+      }
+    c->stop_gen=h->stop_gen;
+    c->sel_gen=h->sel_gen;
+    h->eval_cache=c;
+   }
+ else if (c->stop_gen!=h->stop_gen)
+   {
+    mi_eval_cache_clear(c);
+    c->stop_gen=h->stop_gen;
+    c->sel_gen=h->sel_gen;
+   }
+ else if (c->sel_gen!=h->sel_gen)
+   {
+    mi_eval_cache_drop_current(c);
+    c->sel_gen=h->sel_gen;
+   }
+ return c;
+}
+
+static
+void mi_eval_cache_grow(mi_eval_cache *c)
+{
+ int nb=c->buckets*2, i;
+ mi_eval_entry **nt, *e, *aux;
+
+ nt=(mi_eval_entry **)calloc(nb,sizeof(mi_eval_entry *));
+ if (!nt)
+    return; /* Just slower. */
+ for (i=0; i<c->buckets; i++)
+     for (e=c->table[i]; e; e=aux)
+        {
+         aux=e->next;
+         e->next=nt[e->hash & (nb-1)];
+         nt[e->hash & (nb-1)]=e;
+        }
+ free(c->table);
+ c->table=nt;
+ c->buckets=nb;
+}
+
+/* Finds the entry for this expression, if create!=0 creates an empty one
+   when not found. */
+static
+mi_eval_entry *mi_eval_cache_lookup(mi_eval_cache *c, const char *exp,
+                                    int thread, int frame, int create)
+{
+ unsigned hash=mi_eval_hash(exp,thread,frame);
+ mi_eval_entry *e;
+
+ for (e=c->table[hash & (c->buckets-1)]; e; e=e->next)
+     if (e->hash==hash && e->thread==thread && e->frame==frame &&
+         strcmp(e->exp,exp)==0)
+        return e;
+ if (!create)
+    return NULL;
+ e=(mi_eval_entry *)mi_calloc1(sizeof(mi_eval_entry));
+ if (!e)
+    return NULL;
+ e->exp=strdup(exp);
+ if (!e->exp)
+   {
+    free(e);
+    mi_error=MI_OUT_OF_MEMORY;
+    return NULL;
+   }
+ e->thread=thread;
+ e->frame=frame;
+ e->hash=hash;
+ if (c->count>=c->buckets)
+    mi_eval_cache_grow(c);
+ e->next=c->table[hash & (c->buckets-1)];
+ c->table[hash & (c->buckets-1)]=e;
+ c->count++;
+ return e;
+}
+
+typedef struct
+{
+ mi_eval_entry **pending;
+} mi_eval_batch;
+
+static
+void mi_eval_batch_send(mi_h *h, int i, void *data)
+{
+ mi_eval_entry *e=((mi_eval_batch *)data)->pending[i];
+ mi_data_evaluate_expression_tf(h,e->exp,e->thread,e->frame);
+}
+
+static
+int mi_eval_batch_recv(mi_h *h, int i, void *data)
+{
+ mi_eval_entry *e=((mi_eval_batch *)data)->pending[i];
+
+ e->value=mi_res_value(h);
+ if (e->value)
+   {
+    e->state=1;
+    return 1;
+   }
+ if (mi_error==MI_FROM_GDB && mi_error_from_gdb)
+   {
+    e->value=strdup(mi_error_from_gdb);
+    e->state=2;
+   }
+ return 0;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Evaluates @var{count} expressions. The expressions that aren't in the
+cache are sent to gdb using a pipeline (@x{mi_pipeline}), repeated
+expressions are sent only once. The results are kept until the target
+resumes or stops, so asking again for the same expressions in the same
+@var{thread} and @var{frame} doesn't involve gdb. Use -1 for @var{thread}
+and @var{frame} to use the current ones. Note that selecting another
+thread or frame using this library discards the values cached for the
+current ones.@*
+  The values are returned in @var{values}, in the same order, NULL for the
+ones that failed. If @var{errors} isn't NULL the error messages from gdb
+are returned there (NULL for the ones that didn't fail). All the strings
+are new copies, release them using free.@*
+  Don't use it for expressions with side effects.
+
+  Command: -data-evaluate-expression (pipelined)
+  Return: The number of expressions successfully evaluated or -1 if gdb died
+or didn't answer.
+
+***************************************************************************/
+
+int gmi_data_evaluate_expressions(mi_h *h, int count, const char **exps,
+                                  int thread, int frame, char **values,
+                                  char **errors)
+{
+ mi_eval_cache *c;
+ mi_eval_batch b;
+ mi_eval_entry *e;
+ int i, npending=0, ok=0;
+
+ for (i=0; i<count; i++)
+    {
+     values[i]=NULL;
+     if (errors)
+        errors[i]=NULL;
+    }
+ c=mi_get_eval_cache(h);
+ if (!c)
+    return -1;
+ b.pending=(mi_eval_entry **)mi_calloc(count ? count : 1,
+                                       sizeof(mi_eval_entry *));
+ if (!b.pending)
+    return -1;
+ /* Create entries for the new ones, they will be filled by the pipeline. */
+ for (i=0; i<count; i++)
+    {
+     e=mi_eval_cache_lookup(c,exps[i],thread,frame,1);
+     if (!e)
+       {
+        free(b.pending);
+        return -1;
+       }
+     if (!e->state && !e->value)
+       {
+        b.pending[npending++]=e;
+        e->state=-1; /* Scheduled, avoid sending it twice. */
+       }
+    }
+ if (npending && mi_pipeline(h,npending,mi_eval_batch_send,
+                             mi_eval_batch_recv,&b)<0)
+   {/* The dialog is broken, don't trust anything. */
+    mi_eval_cache_clear(c);
+    free(b.pending);
+    return -1;
+   }
+ free(b.pending);
+ /* Fill the results from the cache. */
+ for (i=0; i<count; i++)
+    {
+     e=mi_eval_cache_lookup(c,exps[i],thread,frame,0);
+     if (!e)
+        continue;
+     if (e->state==1)
+       {
+        values[i]=strdup(e->value);
+        ok++;
+       }
+     else if (e->state==2 && errors)
+        errors[i]=strdup(e->value);
+     else if (e->state==-1)
+        e->state=0; /* Failed without message, try again next time. */
+    }
+ return ok;
+}
+
 /**[txh]********************************************************************
 
   Description:
@@ -221,6 +541,171 @@ mi_asm_insns *gmi_data_disassemble_fl(mi_h *h, const char *file, int line,
  return mi_get_asm_insns(h);
 }
 
+#define MI_ASM_STREAM_CHUNK 4096
+
+typedef struct
+{
+ void *start, *end;
+ int chunk;
+ char *next;    /* Where the next instruction must start. */
+ int known;     /* We know the size of the last one. */
+ mi_asm_cb cb;
+ void *data;
+ int count;     /* Instructions delivered. */
+ int stop;
+} mi_asm_stream;
+
+static
+char *mi_asm_stream_end(mi_asm_stream *st, int i)
+{
+ char *end=(char *)st->start+(unsigned long)(i+1)*st->chunk;
+
+ return end>(char *)st->end ? (char *)st->end : end;
+}
+
+static
+void mi_asm_stream_send(mi_h *h, mi_asm_stream *st, int i)
+{
+ char s[32], e[32];
+
+ snprintf(s,32,"%p",(char *)st->start+(unsigned long)i*st->chunk);
+ snprintf(e,32,"%p",mi_asm_stream_end(st,i));
+ mi_data_disassemble_se(h,s,e,2);
+}
+
+/* First instruction that starts at or after a. */
+static
+mi_asm_insn *mi_asm_stream_skip(mi_asm_insns *l, char *a)
+{
+ mi_asm_insn *i=l ? l->ins : NULL;
+
+ while (i && (char *)i->addr<a)
+    i=i->next;
+ return i;
+}
+
+/* The chunk i was decoded from an instruction boundary or the decoder
+synchronized at st->next. */
+static
+int mi_asm_stream_synced(mi_asm_stream *st, mi_asm_insns *l, int i)
+{
+ mi_asm_insn *ins=mi_asm_stream_skip(l,st->next);
+
+ return !st->known || !ins || (char *)ins->addr==st->next ||
+        st->next>=mi_asm_stream_end(st,i);
+}
+
+/* Delivers the instructions of the chunk i. If the last instruction of the
+previous chunk crossed the limit the chunk was decoded from the middle of
+an instruction, we keep the instructions after it only if the decoder
+synchronized, otherwise the chunk is requested again from the right place.
+Only called when no other commands are waiting for a response. */
+static
+int mi_asm_stream_chunk(mi_h *h, mi_asm_stream *st, mi_asm_insns *l, int i)
+{
+ char e[32], s[32];
+ mi_asm_insn *ins;
+
+ if (!l)
+    return 0;
+ ins=mi_asm_stream_skip(l,st->next);
+ if (!mi_asm_stream_synced(st,l,i))
+   {
+    mi_free_asm_insns(l);
+    snprintf(s,32,"%p",st->next);
+    snprintf(e,32,"%p",mi_asm_stream_end(st,i));
+    mi_data_disassemble_se(h,s,e,2);
+    l=mi_get_asm_insns(h);
+    if (!l)
+       return 0;
+    ins=mi_asm_stream_skip(l,st->next);
+   }
+ for (; ins && !st->stop; ins=ins->next)
+    {
+     /* Old gdbs don't report the opcodes, trust the chunk limits. */
+     st->known=ins->size>0;
+     st->next=(char *)ins->addr+(st->known ? ins->size : 1);
+     st->count++;
+     if (!st->cb(ins,st->data))
+        st->stop=1;
+    }
+ mi_free_asm_insns(l);
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Disassembles from @var{start} to @var{end}, @var{end} not included,
+passing each instruction to @var{cb}. The range is split in chunks of
+@var{chunk} bytes (0 means 4 kB) and the chunks are requested using a
+pipeline (see @x{mi_set_pipeline_depth}), so only a few chunks are in
+memory. If the callback returns 0 no more chunks are requested. The
+instruction passed to the callback is released after the call. The raw
+opcodes are requested to know the size of the instructions, needed to
+find the limit of the instructions that cross a chunk limit.
+
+  Command: -data-disassemble -s -e -- 2
+  Return: The number of instructions passed to @var{cb} or -1 on error.
+
+***************************************************************************/
+
+int gmi_data_disassemble_stream(mi_h *h, void *start, void *end, int chunk,
+                                mi_asm_cb cb, void *data)
+{
+ mi_asm_stream st;
+ mi_asm_insns **pend;
+ int count, sent=0, done=0, npend, j, ret=0;
+ int depth=h->pipeline_depth>0 ? h->pipeline_depth : 1;
+
+ if (end<=start)
+    return 0;
+ st.start=start;
+ st.end=end;
+ st.chunk=chunk>0 ? chunk : MI_ASM_STREAM_CHUNK;
+ st.next=(char *)start;
+ st.known=1;
+ st.cb=cb;
+ st.data=data;
+ st.count=st.stop=0;
+ count=((char *)end-(char *)start+st.chunk-1)/st.chunk;
+ pend=(mi_asm_insns **)mi_calloc(depth,sizeof(mi_asm_insns *));
+ if (!pend)
+    return -1;
+ while (done<count)
+   {
+    while (!st.stop && sent<count && sent-done<depth)
+       mi_asm_stream_send(h,&st,sent++);
+    if (done==sent)
+       break;
+    mi_error=MI_OK;
+    pend[0]=mi_get_asm_insns(h);
+    npend=1;
+    if (!pend[0] && (mi_error==MI_GDB_DIED || mi_error==MI_GDB_TIME_OUT))
+      {
+       ret=-1;
+       break;
+      }
+    /* The chunk needs a new request, get the ones in flight first. */
+    if (!mi_asm_stream_synced(&st,pend[0],done))
+       while (done+npend<sent)
+          pend[npend++]=mi_get_asm_insns(h);
+    for (j=0; j<npend; j++)
+       {
+        if (st.stop)
+           mi_free_asm_insns(pend[j]);
+        else if (!mi_asm_stream_chunk(h,&st,pend[j],done+j))
+          {
+           ret=-1;
+           st.stop=1;
+          }
+       }
+    done+=npend;
+   }
+ free(pend);
+ return ret<0 ? -1 : st.count;
+}
+
 // Affected by gdb bug mi/1770
 mi_chg_reg *gmi_data_list_register_names(mi_h *h, int *how_many)
 {
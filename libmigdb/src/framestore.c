@@ -0,0 +1,342 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Frame store.
+  Comments:
+  A compact storage for a lot of stacks, i.e. collected while profiling or
+for crash triage. Each mi_frames node owns its strings, so the same names
+are repeated for every stack. Here the strings are interned in a string
+table (@x{mi_new_strtab}), that can be shared, and each different frame is
+stored only once as a fixed size record. A stack is just an array of
+record indexes.@p
+
+  The arguments aren't stored, the level is the position in the stack.
+Use @x{mi_frame_store_get} to get a regular mi_frames list.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include "mi_gdb.h"
+
+#define MI_FSTORE_SLOTS 256
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates an empty frame store. The strings are interned in @var{strs},
+that can be shared with other objects (i.e. a profile). If @var{strs} is
+NULL the store creates its own table.
+
+  Return: A new store or NULL on error. Release it using
+@x{mi_free_frame_store}.
+
+***************************************************************************/
+
+mi_frame_store *mi_new_frame_store(mi_strtab *strs)
+{
+ mi_frame_store *fs=(mi_frame_store *)mi_calloc1(sizeof(mi_frame_store));
+
+ if (!fs)
+    return NULL;
+ if (strs)
+    fs->strs=strs;
+ else
+   {
+    fs->strs=mi_new_strtab();
+    fs->own_strs=1;
+   }
+ fs->buckets=MI_FSTORE_SLOTS;
+ fs->table=(int *)mi_malloc(fs->buckets*sizeof(int));
+ fs->stk_start=(int *)mi_malloc(MI_FSTORE_SLOTS*sizeof(int));
+ fs->stk_thread=(int *)mi_malloc(MI_FSTORE_SLOTS*sizeof(int));
+ if (!fs->strs || !fs->table || !fs->stk_start || !fs->stk_thread)
+   {
+    mi_free_frame_store(fs);
+    return NULL;
+   }
+ memset(fs->table,0xFF,fs->buckets*sizeof(int));
+ fs->astacks=MI_FSTORE_SLOTS-1;
+ fs->stk_start[0]=0;
+ return fs;
+}
+
+void mi_free_frame_store(mi_frame_store *fs)
+{
+ if (!fs)
+    return;
+ if (fs->own_strs)
+    mi_free_strtab(fs->strs);
+ free(fs->recs);
+ free(fs->table);
+ free(fs->stk_data);
+ free(fs->stk_start);
+ free(fs->stk_thread);
+ free(fs);
+}
+
+static
+unsigned mi_fstore_hash(mi_frame_rec *r)
+{
+ unsigned hash=2166136261u;
+
+ hash=(hash^(unsigned)(unsigned long)r->addr)*16777619u;
+ hash=(hash^(unsigned)r->func)*16777619u;
+ hash=(hash^(unsigned)r->file)*16777619u;
+ hash=(hash^(unsigned)r->from)*16777619u;
+ return (hash^(unsigned)r->line)*16777619u;
+}
+
+static
+int mi_fstore_same(mi_frame_rec *a, mi_frame_rec *b)
+{
+ return a->addr==b->addr && a->func==b->func && a->file==b->file &&
+        a->from==b->from && a->line==b->line;
+}
+
+static
+int mi_fstore_grow_table(mi_frame_store *fs)
+{
+ int nb=fs->buckets*2, i, j, *nt;
+
+ nt=(int *)mi_malloc(nb*sizeof(int));
+ if (!nt)
+    return 0;
+ memset(nt,0xFF,nb*sizeof(int));
+ for (i=0; i<fs->nrecs; i++)
+    {
+     j=mi_fstore_hash(fs->recs+i) & (nb-1);
+     while (nt[j]>=0)
+        j=(j+1) & (nb-1);
+     nt[j]=i;
+    }
+ free(fs->table);
+ fs->table=nt;
+ fs->buckets=nb;
+ return 1;
+}
+
+/* Returns the index of the record equal to r, adding it if needed. */
+static
+int mi_fstore_rec(mi_frame_store *fs, mi_frame_rec *r)
+{
+ int i, id;
+
+ if ((fs->nrecs+1)*2>fs->buckets && !mi_fstore_grow_table(fs))
+    return -1;
+ i=mi_fstore_hash(r) & (fs->buckets-1);
+ while ((id=fs->table[i])>=0)
+   {
+    if (mi_fstore_same(fs->recs+id,r))
+       return id;
+    i=(i+1) & (fs->buckets-1);
+   }
+ if (fs->nrecs>=fs->arecs)
+   {
+    int n=fs->arecs ? fs->arecs*2 : MI_FSTORE_SLOTS;
+    mi_frame_rec *nr=(mi_frame_rec *)realloc(fs->recs,n*sizeof(mi_frame_rec));
+    if (!nr)
+      {
+       mi_error=MI_OUT_OF_MEMORY;
+       return -1;
+      }
+    fs->recs=nr;
+    fs->arecs=n;
+   }
+ fs->recs[fs->nrecs]=*r;
+ fs->table[i]=fs->nrecs;
+ return fs->nrecs++;
+}
+
+static
+int mi_fstore_str(mi_frame_store *fs, const char *s, int *id)
+{
+ *id=-1;
+ if (!s)
+    return 1;
+ *id=mi_strtab_intern(fs->strs,s);
+ return *id>=0;
+}
+
+/* Makes room for one more stack with n frames. */
+static
+int mi_fstore_reserve(mi_frame_store *fs, int n)
+{
+ int used=fs->stk_start[fs->nstacks];
+
+ if (used+n>fs->astk_data)
+   {
+    int size=fs->astk_data ? fs->astk_data : 1024;
+    int *d;
+    while (used+n>size)
+       size*=2;
+    d=(int *)realloc(fs->stk_data,size*sizeof(int));
+    if (!d)
+      {
+       mi_error=MI_OUT_OF_MEMORY;
+       return 0;
+      }
+    fs->stk_data=d;
+    fs->astk_data=size;
+   }
+ if (fs->nstacks>=fs->astacks)
+   {
+    int size=(fs->astacks+1)*2;
+    int *s=(int *)realloc(fs->stk_start,size*sizeof(int));
+    int *t=s ? (int *)realloc(fs->stk_thread,size*sizeof(int)) : NULL;
+    if (s)
+       fs->stk_start=s;
+    if (!t)
+      {
+       mi_error=MI_OUT_OF_MEMORY;
+       return 0;
+      }
+    fs->stk_thread=t;
+    fs->astacks=size-1;
+   }
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Adds a copy of the @var{f} list of frames to the store.
+
+  Return: The index of the new stack or -1 on error.
+
+***************************************************************************/
+
+int mi_frame_store_add(mi_frame_store *fs, mi_frames *f)
+{
+ mi_frames *c;
+ mi_frame_rec r;
+ int n=0, id, *d;
+
+ for (c=f; c; c=c->next)
+     n++;
+ if (!mi_fstore_reserve(fs,n))
+    return -1;
+ d=fs->stk_data+fs->stk_start[fs->nstacks];
+ for (c=f; c; c=c->next)
+    {
+     r.addr=c->addr;
+     r.line=c->line;
+     if (!mi_fstore_str(fs,c->func,&r.func) ||
+         !mi_fstore_str(fs,c->file,&r.file) ||
+         !mi_fstore_str(fs,c->from,&r.from))
+        return -1;
+     id=mi_fstore_rec(fs,&r);
+     if (id<0)
+        return -1;
+     *(d++)=id;
+    }
+ fs->stk_thread[fs->nstacks]=f ? f->thread_id : 0;
+ fs->stk_start[fs->nstacks+1]=fs->stk_start[fs->nstacks]+n;
+ return fs->nstacks++;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the number of frames in @var{stack}.
+
+  Return: The depth or -1 if the stack doesn't exist.
+
+***************************************************************************/
+
+int mi_frame_store_depth(mi_frame_store *fs, int stack)
+{
+ if (stack<0 || stack>=fs->nstacks)
+    return -1;
+ return fs->stk_start[stack+1]-fs->stk_start[stack];
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the frame at @var{level} for @var{stack}. The strings can be
+obtained using @x{mi_strtab_str}.
+
+  Return: The record, owned by the store, or NULL if it doesn't exist.
+
+***************************************************************************/
+
+mi_frame_rec *mi_frame_store_frame(mi_frame_store *fs, int stack, int level)
+{
+ if (level<0 || level>=mi_frame_store_depth(fs,stack))
+    return NULL;
+ return fs->recs+fs->stk_data[fs->stk_start[stack]+level];
+}
+
+static
+int mi_fstore_dup(mi_frame_store *fs, int id, char **dest)
+{
+ const char *s=mi_strtab_str(fs->strs,id);
+
+ if (!s)
+    return 1;
+ *dest=strdup(s);
+ if (*dest)
+    return 1;
+ mi_error=MI_OUT_OF_MEMORY;
+ return 0;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates a mi_frames list for @var{stack}. The arguments aren't filled.
+
+  Return: A new list or NULL on error.
+
+***************************************************************************/
+
+mi_frames *mi_frame_store_get(mi_frame_store *fs, int stack)
+{
+ mi_frames *first=NULL, *last=NULL, *f;
+ mi_frame_rec *r;
+ int i, n=mi_frame_store_depth(fs,stack);
+
+ for (i=0; i<n; i++)
+    {
+     r=mi_frame_store_frame(fs,stack,i);
+     f=mi_alloc_frames();
+     if (!f)
+       {
+        mi_free_frames(first);
+        return NULL;
+       }
+     if (last)
+        last->next=f;
+     else
+        first=f;
+     last=f;
+     f->level=i;
+     f->addr=r->addr;
+     f->line=r->line;
+     f->thread_id=fs->stk_thread[stack];
+     if (!mi_fstore_dup(fs,r->func,&f->func) ||
+         !mi_fstore_dup(fs,r->file,&f->file) ||
+         !mi_fstore_dup(fs,r->from,&f->from))
+       {
+        mi_free_frames(first);
+        return NULL;
+       }
+    }
+ return first;
+}
@@ -0,0 +1,296 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Breakpoint hit statistics.
+  Comments:
+  When enabled, each *stopped record with reason breakpoint-hit is counted
+for its breakpoint and time stamped as soon as it's received, before the
+application calls @x{mi_res_stop}. The time from the stop to the next
+resume is added to the breakpoint. With it we can find the breakpoints
+that slow down the target and convert them into cheaper forms.@p
+
+  The times are in microseconds. The records are stored in an array, with
+a hash table by breakpoint number.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include <time.h>
+#include "mi_gdb.h"
+
+#define MI_HITS_SLOTS 64
+
+/* Monotonic, a change of the wall clock doesn't affect the intervals. */
+static
+unsigned long long mi_hits_now()
+{
+ struct timespec ts;
+
+ clock_gettime(CLOCK_MONOTONIC,&ts);
+ return (unsigned long long)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+
+static
+void mi_free_hit_stats(mi_hit_stats *s)
+{
+ if (!s)
+    return;
+ free(s->recs);
+ free(s->table);
+ free(s);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Enables or disables the collection of breakpoint hit statistics.
+Disabling it releases the collected data.
+
+  Return: !=0 OK
+
+***************************************************************************/
+
+int mi_enable_hit_stats(mi_h *h, int enable)
+{
+ mi_hit_stats *s;
+
+ if (!enable)
+   {
+    mi_free_hit_stats(h->hit_stats);
+    h->hit_stats=NULL;
+    return 1;
+   }
+ if (h->hit_stats)
+    return 1;
+ s=(mi_hit_stats *)mi_calloc1(sizeof(mi_hit_stats));
+ if (!s)
+    return 0;
+ s->buckets=MI_HITS_SLOTS;
+ s->table=(int *)mi_malloc(s->buckets*sizeof(int));
+ if (!s->table)
+   {
+    mi_free_hit_stats(s);
+    return 0;
+   }
+ memset(s->table,0xFF,s->buckets*sizeof(int));
+ s->cur=-1;
+ h->hit_stats=s;
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Forgets the collected data, the collection continues.
+
+***************************************************************************/
+
+void mi_hit_stats_reset(mi_h *h)
+{
+ mi_hit_stats *s=h->hit_stats;
+
+ if (!s)
+    return;
+ s->nrecs=0;
+ s->cur=-1;
+ memset(s->table,0xFF,s->buckets*sizeof(int));
+}
+
+static
+int mi_hits_slot(mi_hit_stats *s, int number)
+{
+ int i=((unsigned)number*2654435761u) & (s->buckets-1);
+
+ while (s->table[i]>=0 && s->recs[s->table[i]].number!=number)
+    i=(i+1) & (s->buckets-1);
+ return i;
+}
+
+static
+int mi_hits_grow(mi_hit_stats *s)
+{
+ int nb=s->buckets*2, i, *nt=(int *)malloc(nb*sizeof(int)), *old;
+
+ if (!nt)
+    return 0;
+ memset(nt,0xFF,nb*sizeof(int));
+ old=s->table;
+ s->table=nt;
+ s->buckets=nb;
+ for (i=0; i<s->nrecs; i++)
+     s->table[mi_hits_slot(s,s->recs[i].number)]=i;
+ free(old);
+ return 1;
+}
+
+/* Returns the record for number, creating it if create!=0. */
+static
+mi_bkpt_hits *mi_hits_get(mi_hit_stats *s, int number, int create)
+{
+ int i=mi_hits_slot(s,number);
+ mi_bkpt_hits *r;
+
+ if (s->table[i]>=0)
+    return s->recs+s->table[i];
+ if (!create)
+    return NULL;
+ if ((s->nrecs+1)*2>s->buckets)
+   {
+    if (!mi_hits_grow(s))
+       return NULL;
+    i=mi_hits_slot(s,number);
+   }
+ if (s->nrecs>=s->arecs)
+   {
+    int n=s->arecs ? s->arecs*2 : MI_HITS_SLOTS;
+    r=(mi_bkpt_hits *)realloc(s->recs,n*sizeof(mi_bkpt_hits));
+    if (!r)
+       return NULL;
+    s->recs=r;
+    s->arecs=n;
+   }
+ r=s->recs+s->nrecs;
+ memset(r,0,sizeof(mi_bkpt_hits));
+ r->number=number;
+ r->times=-1;
+ s->table[i]=s->nrecs++;
+ return r;
+}
+
+/* Closes the stop in progress, if any. */
+static
+void mi_hits_resumed(mi_hit_stats *s, unsigned long long now)
+{
+ if (s->cur<0)
+    return;
+ s->recs[s->cur].stopped+=now-s->stop_start;
+ s->cur=-1;
+}
+
+/* Called for each record received, see mi_get_response. */
+void mi_hit_stats_record(mi_h *h, mi_output *o)
+{
+ mi_hit_stats *s=h->hit_stats;
+ mi_results *r;
+ mi_bkpt_hits *b;
+ unsigned long long now;
+ int hit=0, number=-1;
+
+ if ((o->type==MI_T_RESULT_RECORD && o->tclass==MI_CL_RUNNING) ||
+     (o->type==MI_T_OUT_OF_BAND && o->stype==MI_ST_ASYNC &&
+      o->tclass==MI_CL_RUNNING))
+   {
+    mi_hits_resumed(s,mi_hits_now());
+    return;
+   }
+ if (o->type!=MI_T_OUT_OF_BAND || o->stype!=MI_ST_ASYNC ||
+     o->tclass!=MI_CL_STOPPED)
+    return;
+ now=mi_hits_now();
+ /* In non-stop mode other thread could be stopped here. */
+ mi_hits_resumed(s,now);
+ for (r=o->c; r; r=r->next)
+     if (r->type==t_const && r->var)
+       {
+        if (strcmp(r->var,"reason")==0)
+           hit=strcmp(r->v.cstr,"breakpoint-hit")==0;
+        else if (strcmp(r->var,"bkptno")==0)
+           number=atoi(r->v.cstr);
+       }
+ if (!hit || number<0 || !(b=mi_hits_get(s,number,1)))
+    return;
+ if (!b->hits)
+    b->first=now;
+ b->last=now;
+ b->hits++;
+ s->cur=b-s->recs;
+ s->stop_start=now;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the statistics for the breakpoint @var{number}.
+
+  Return: The record, owned by the handle, or NULL if the breakpoint wasn't
+hit or the statistics aren't enabled. The pointer is valid until the next
+response is received.
+
+***************************************************************************/
+
+mi_bkpt_hits *mi_get_bkpt_hits(mi_h *h, int number)
+{
+ if (!h->hit_stats)
+    return NULL;
+ return mi_hits_get(h->hit_stats,number,0);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the statistics for all the breakpoints, in the order they were seen
+for the first time. The stopped field doesn't include the stop in
+progress.
+
+  Return: An array of @var{count} records, owned by the handle, or NULL.
+
+***************************************************************************/
+
+mi_bkpt_hits *mi_get_all_bkpt_hits(mi_h *h, int *count)
+{
+ *count=h->hit_stats ? h->hit_stats->nrecs : 0;
+ return *count ? h->hit_stats->recs : NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Mean time between two hits of the breakpoint.
+
+  Return: The time in microseconds, 0 if it was hit less than two times.
+
+***************************************************************************/
+
+unsigned long long mi_bkpt_hits_interval(mi_bkpt_hits *b)
+{
+ if (b->hits<2)
+    return 0;
+ return (b->last-b->first)/(b->hits-1);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Merges the times field reported by gdb for the breakpoints in the
+@var{b} list (i.e. from -break-insert, -break-list or a breakpoint-modified
+event). It includes the hits skipped because of the ignore count.
+Breakpoints that weren't hit get a record.
+
+***************************************************************************/
+
+void mi_hit_stats_merge(mi_h *h, mi_bkpt *b)
+{
+ mi_bkpt_hits *r;
+
+ if (!h->hit_stats)
+    return;
+ for (; b; b=b->next)
+     if (b->number>0 && (r=mi_hits_get(h->hit_stats,b->number,1))!=NULL)
+        r->times=b->times;
+}
@@ -44,7 +44,8 @@ extern "C" {
 #define MI_MISSING_XTERM          11
 #define MI_CREATE_TEMPORAL        12
 #define MI_MISSING_GDB            13
-#define MI_LAST_ERROR             13
+#define MI_UNSUPPORTED            14
+#define MI_LAST_ERROR             14
 
 #define MI_R_NONE                  0 /* We are no waiting any response. */
 #define MI_R_SKIP                  1 /* We want to discard it. */
@@ -79,8 +80,39 @@ enum mi_val_type { t_const, t_tuple, t_list };
 #define MI_CL_CONNECTED    4
 #define MI_CL_ERROR        5
 #define MI_CL_EXIT         6
+/* Async classes, *running uses MI_CL_RUNNING. */
+#define MI_CL_THREAD_CREATED 7
+#define MI_CL_THREAD_EXITED  8
+#define MI_CL_THREAD_GROUP_ADDED   9
+#define MI_CL_THREAD_GROUP_REMOVED 10
+#define MI_CL_THREAD_GROUP_STARTED 11
+#define MI_CL_THREAD_GROUP_EXITED  12
+#define MI_CL_THREAD_SELECTED      13
+#define MI_CL_LIBRARY_LOADED       14
+#define MI_CL_LIBRARY_UNLOADED     15
+#define MI_CL_BREAKPOINT_CREATED   16
+#define MI_CL_BREAKPOINT_MODIFIED  17
+#define MI_CL_BREAKPOINT_DELETED   18
+#define MI_CL_CMD_PARAM_CHANGED    19
+#define MI_CL_MEMORY_CHANGED       20
+/* Masks for the notifications we want, see mi_set_notify_mask. */
+#define MI_EV_MASK(cl)    (1u<<(cl))
+#define MI_EV_ALL         (~MI_EV_MASK(MI_CL_UNKNOWN))
+/* The ones parsed before the events were introduced, the rest are opt-in. */
+#define MI_EV_DEFAULT     (MI_EV_MASK(MI_CL_STOPPED) | MI_EV_MASK(MI_CL_DOWNLOAD) |\
+                           MI_EV_MASK(MI_CL_RUNNING) |\
+                           MI_EV_MASK(MI_CL_THREAD_CREATED) |\
+                           MI_EV_MASK(MI_CL_THREAD_EXITED))
+/* For the --thread option of the exec commands, means --all. */
+#define MI_ALL_THREADS    -1
 
 #define MI_DEFAULT_TIME_OUT 10
+/* How many commands we send before waiting for the first response when
+   using a pipeline. */
+#define MI_DEFAULT_PIPELINE_DEPTH 32
+/* Frames requested at once by a backtrace and its default limit. */
+#define MI_DEFAULT_BT_PAGE       20
+#define MI_DEFAULT_BT_MAX_DEPTH  10000
 
 #define MI_DIS_ASM        0
 #define MI_DIS_SRC_ASM    1
@@ -124,8 +156,46 @@ typedef struct mi_output_struct mi_output;
 
 typedef void (*stream_cb)(const char *, void *);
 typedef void (*async_cb)(mi_output *o, void *);
+struct mi_event_struct;
+typedef void (*event_cb)(struct mi_event_struct *e, void *);
 typedef int  (*tm_cb)(void *);
 
+/* Opaque, see data_man.c */
+typedef struct mi_eval_cache_struct mi_eval_cache;
+/* Opaque, see reader.c */
+struct mi_reader_struct;
+typedef struct mi_reader_struct mi_reader;
+
+/* Hit statistics for a breakpoint, see hit_stats.c. Times in us. */
+struct mi_bkpt_hits_struct
+{
+ int number;
+ unsigned hits;       /* Stops reported for this breakpoint. */
+ int times;           /* Hits reported by gdb, -1 if unknown. */
+ unsigned long long first, last; /* First and last stop. */
+ unsigned long long stopped;     /* Total time stopped here. */
+};
+typedef struct mi_bkpt_hits_struct mi_bkpt_hits;
+
+struct mi_hit_stats_struct
+{
+ mi_bkpt_hits *recs;
+ int nrecs, arecs;
+ int *table;          /* Hash table by number, indexes for recs. */
+ int buckets;
+ int cur;             /* The one we are stopped at, -1 if none. */
+ unsigned long long stop_start;
+};
+typedef struct mi_hit_stats_struct mi_hit_stats;
+
+/* Run state of a thread, see mi_get_thread_state. */
+struct mi_thread_state_struct
+{
+ int id;
+ char running;
+};
+typedef struct mi_thread_state_struct mi_thread_state;
+
 /* Values of this structure shouldn't be manipulated by the user. */
 struct mi_h_struct
 {
@@ -154,6 +224,10 @@ struct mi_h_struct
  /* Async responses callback. */
  async_cb async;
  void *async_data;
+ /* Decoded notifications callback and the ones we want (MI_EV_MASK). */
+ event_cb event;
+ void *event_data;
+ unsigned notify_mask;
  /* Callbacks to get echo of gdb dialog. */
  stream_cb to_gdb_echo;
  void *to_gdb_echo_data;
@@ -166,16 +240,49 @@ struct mi_h_struct
  /* Ugly workaround for some of the show responses :-( */
  int catch_console;
  char *catched_console;
+ /* Raw ^done records, parsed by the caller. Used for speed. */
+ int catch_result;
+ char *catched_result;
+ int catched_result_size;
  /* MI version, currently unknown but the user can force v2 */
  unsigned version;
+ /* How many commands can be waiting for a response in a pipeline. */
+ int pipeline_depth;
+ /* Incremented when the target resumes or stops, used to invalidate the
+    information we cache. */
+ unsigned stop_gen;
+ /* Incremented when the selected frame or thread (sel_gen) or just the
+    thread (thread_gen) changes. Only the information that depends on the
+    selection is discarded. */
+ unsigned sel_gen, thread_gen;
+ /* Results of -data-evaluate-expression for the current stop. */
+ mi_eval_cache *eval_cache;
+ /* Non-stop mode: run state of each thread and async records received
+    while waiting for a result. */
+ char non_stop;
+ mi_thread_state *thr_states;
+ int nthr_states, athr_states;
+ int *thr_index;      /* Positions in thr_states, hashed by id. */
+ int thr_buckets;
+ mi_output *async_po, *async_last;
+ /* Optional thread that reads and parses the gdb output. */
+ mi_reader *reader;
+ /* Breakpoint hit statistics, only if enabled. */
+ mi_hit_stats *hit_stats;
 };
 typedef struct mi_h_struct mi_h;
 
 #define MI_TO(a) ((a)->to_gdb[1])
 
-enum mi_bkp_type { t_unknown=0, t_breakpoint=1, t_hw=2 };
+enum mi_bkp_type { t_unknown=0, t_breakpoint=1, t_hw=2, t_dprintf=3,
+                  t_tracepoint=4,
+                  /* Reported by -break-list for watchpoints. */
+                  t_watchpoint=5, t_hw_watchpoint=6, t_read_watchpoint=7,
+                  t_acc_watchpoint=8 };
 enum mi_bkp_disp { d_unknown=0, d_keep=1, d_del=2 };
 enum mi_bkp_mode { m_file_line=0, m_function=1, m_file_function=2, m_address=3 };
+/* Where the conditions are evaluated. */
+enum mi_cond_eval { ce_auto=0, ce_host=1, ce_target=2 };
 
 struct mi_bkpt_struct
 {
@@ -189,6 +296,7 @@ struct mi_bkpt_struct
  int line;
  int ignore;
  int times;
+ char cond_target; /* The condition is evaluated by the target. */
 
  /* For the user: */
  char *cond;
@@ -196,9 +304,23 @@ struct mi_bkpt_struct
  int thread;
  enum mi_bkp_mode mode;
  struct mi_bkpt_struct *next;
+ /* Next breakpoint in the same buckets of a table (mi_bkpt_tab) and
+    previous in the list of the table. */
+ struct mi_bkpt_struct *hnext, *lnext, *prev;
 };
 typedef struct mi_bkpt_struct mi_bkpt;
 
+/* Breakpoint table, see bkpt_tab.c */
+struct mi_bkpt_tab_struct
+{
+ mi_bkpt *list;   /* Owned breakpoints. */
+ mi_bkpt **num;   /* Hash table by number. */
+ mi_bkpt **loc;   /* Hash table by location (file:line or address). */
+ int buckets;
+ int count;
+};
+typedef struct mi_bkpt_tab_struct mi_bkpt_tab;
+
 enum mi_wp_mode { wm_unknown=0, wm_write=1, wm_read=2, wm_rw=3 };
 
 struct mi_wp_struct
@@ -213,6 +335,46 @@ struct mi_wp_struct
 };
 typedef struct mi_wp_struct mi_wp;
 
+/* Saved session, see session.c */
+struct mi_session_struct
+{
+ char *path;        /* Source path. */
+ mi_bkpt *bkpts, *last_bkpt;
+ mi_wp *wps, *last_wp;
+ char **exps;       /* Display expressions. */
+ int nexps, aexps;
+};
+typedef struct mi_session_struct mi_session;
+
+/* Hardware watchpoints manager, see watch_man.c */
+struct mi_wman_ent_struct
+{
+ int number;        /* gdb watchpoint. */
+ void *addr;        /* Aligned block. */
+ int len;
+ enum mi_wp_mode mode;
+ int refs;          /* Ranges using this block. */
+ char hw;           /* 0 if gdb used a software watchpoint. */
+ struct mi_wman_ent_struct *next;
+};
+typedef struct mi_wman_ent_struct mi_wman_ent;
+
+struct mi_watch_man_struct
+{
+ int slots;         /* Hardware watchpoints available. */
+ int max_len;       /* Biggest block for a slot. */
+ int used;
+ mi_wman_ent *ents;
+};
+typedef struct mi_watch_man_struct mi_watch_man;
+
+/* Flags for gmi_watch_man_range. */
+#define MI_WM_EXACT    1  /* Don't watch bytes outside the range. */
+#define MI_WM_ALLOW_SW 2  /* Accept software watchpoints. */
+/* Errors from gmi_watch_man_range. */
+#define MI_WM_NO_SLOTS -2
+#define MI_WM_SOFTWARE -3
+
 struct mi_frames_struct
 {
  int level;  /* The frame number, 0 being the topmost frame, i.e. the innermost
@@ -230,6 +392,104 @@ struct mi_frames_struct
 };
 typedef struct mi_frames_struct mi_frames;
 
+/* Information from -thread-info */
+struct mi_thread_struct
+{
+ int id;
+ char *target_id; /* I.e. "Thread 0xb7e156b0 (LWP 21257)" */
+ char *name;      /* If the system provides it. */
+ char running;
+ int core;        /* -1 if unknown. */
+ mi_frames *frame; /* Current frame, NULL if running. */
+ mi_frames *stack; /* Only if requested. */
+ struct mi_thread_struct *next;
+};
+typedef struct mi_thread_struct mi_thread;
+
+/* String table, see strtab.c */
+typedef struct mi_strtab_blk_struct mi_strtab_blk;
+struct mi_strtab_struct
+{
+ int count;     /* Number of strings, the ids go from 0 to count-1. */
+ int size;
+ char **strs;   /* Indexed by id. */
+ int *table;    /* Hash table, -1 is empty. */
+ int buckets;
+ mi_strtab_blk *blks;
+};
+typedef struct mi_strtab_struct mi_strtab;
+
+/* Frame store, see framestore.c */
+struct mi_frame_rec_struct
+{
+ void *addr;
+ int func, file, from; /* Ids in the strings table, -1 if none. */
+ int line;
+};
+typedef struct mi_frame_rec_struct mi_frame_rec;
+
+struct mi_frame_store_struct
+{
+ mi_strtab *strs;
+ char own_strs;
+ /* Different frames. */
+ mi_frame_rec *recs;
+ int nrecs, arecs;
+ int *table;    /* Hash table for recs, -1 is empty. */
+ int buckets;
+ /* Stack i is stk_data[stk_start[i]] to stk_data[stk_start[i+1]-1]. */
+ int *stk_data;
+ int astk_data;
+ int *stk_start;
+ int *stk_thread;
+ int nstacks, astacks;
+};
+typedef struct mi_frame_store_struct mi_frame_store;
+
+/* Sampling profiler, see profiler.c */
+struct mi_prof_node_struct
+{
+ int func;      /* Id in the names table, -1 for the root. */
+ int parent, child, sibling; /* -1 if none. */
+ unsigned incl; /* Samples containing this call path. */
+ unsigned excl; /* Samples where this call path was the whole stack. */
+};
+typedef struct mi_prof_node_struct mi_prof_node;
+
+struct mi_profile_struct
+{
+ mi_strtab *names;    /* Function names. */
+ mi_prof_node *nodes; /* Call tree, 0 is the root. */
+ int nnodes, anodes;
+ /* Per function counts, indexed by the id in names. */
+ unsigned *fincl, *fexcl, *fstamp;
+ int afuncs;
+ int *tmp;
+ int max_depth;
+ unsigned samples;    /* Stacks added. */
+ unsigned stops;      /* Times we stopped the target. */
+ unsigned long long stopped_us; /* Time the target was stopped. */
+ char exited;
+ char stopped;
+};
+typedef struct mi_profile_struct mi_profile;
+
+/* Paged backtrace, see stack_man.c */
+struct mi_backtrace_struct
+{
+ int page;       /* Frames requested at once. */
+ int max_depth;  /* We never look deeper. */
+ int args;       /* -1 no arguments, else the "show" value. */
+ int depth;      /* -1 if not yet known. */
+ char truncated; /* The stack is deeper than max_depth. */
+ unsigned stop_gen;
+ unsigned thread_gen; /* Frames of the selected thread. */
+ int size;
+ mi_frames **frames; /* Indexed by level, NULL if not fetched. */
+ char *pages;        /* Pages already requested. */
+};
+typedef struct mi_backtrace_struct mi_backtrace;
+
 struct mi_aux_term_struct
 {
  pid_t pid;
@@ -276,6 +536,8 @@ struct mi_gvar_struct
  struct mi_gvar_struct *child;
  /* Next var in the list. */
  struct mi_gvar_struct *next;
+ /* Next var in the same bucket of a registry (mi_var_reg). */
+ struct mi_gvar_struct *hnext;
 
  /* For the user: */
  char opened;  /* We will show its children. 1 when we fill "child" */
@@ -292,11 +554,48 @@ struct mi_gvar_chg_struct
  int   in_scope;  /* if true the other fields apply. */
  char *new_type;  /* NULL if type_changed==false */
  int   new_num_children; /* only when new_type!=NULL */
+ char *value;     /* Only if requested, see gmi_var_update_values. */
+ int   type_changed; /* Set by gmi_var_reg_apply when it takes new_type. */
 
  struct mi_gvar_chg_struct *next;
 };
 typedef struct mi_gvar_chg_struct mi_gvar_chg;
 
+/* Variable objects registry, see var_reg.c */
+struct mi_var_reg_struct
+{
+ mi_gvar *roots;  /* Owned variables. */
+ mi_gvar **table; /* Hash table by name. */
+ int buckets;
+ int count;       /* Indexed variables. */
+ mi_gvar **chg;   /* Marked as changed by the last update. */
+ int nchg, achg;
+};
+typedef struct mi_var_reg_struct mi_var_reg;
+
+/* Windows of children, see var_win.c */
+struct mi_child_win_struct
+{
+ int first, count;  /* Children from first to first+count-1. */
+ mi_gvar *child;    /* The list. */
+ mi_gvar **index;   /* The same, as an array. */
+ unsigned stop_gen; /* When we got it. */
+ unsigned stamp;    /* Last use. */
+ int bytes;         /* Estimated memory used. */
+ struct mi_child_win_struct *next;
+};
+typedef struct mi_child_win_struct mi_child_win;
+
+struct mi_child_cache_struct
+{
+ mi_gvar *var;      /* Not owned. */
+ int size;          /* Children in each window. */
+ int budget, used;  /* In bytes. */
+ unsigned clock;
+ mi_child_win *wins;
+};
+typedef struct mi_child_cache_struct mi_child_cache;
+
 
 /* A list of assembler instructions. */
 struct mi_asm_insn_struct
@@ -305,6 +604,7 @@ struct mi_asm_insn_struct
  char *func;
  unsigned offset;
  char *inst;
+ unsigned size; /* In bytes, only for the modes with raw opcodes. */
 
  struct mi_asm_insn_struct *next;
 };
@@ -320,6 +620,33 @@ struct mi_asm_insns_struct
  struct mi_asm_insns_struct *next;
 };
 typedef struct mi_asm_insns_struct mi_asm_insns;
+/* Receives the instructions from gmi_data_disassemble_stream, 0 stops. */
+typedef int (*mi_asm_cb)(mi_asm_insn *ins, void *data);
+
+/* Disassembly cache, see asm_cache.c */
+struct mi_asm_rec_struct
+{
+ void *addr;
+ unsigned offset;
+ int func, inst; /* Ids in the strings table, func is -1 if none. */
+};
+typedef struct mi_asm_rec_struct mi_asm_rec;
+
+struct mi_asm_range_struct
+{
+ void *start, *end; /* end not included. */
+};
+typedef struct mi_asm_range_struct mi_asm_range;
+
+struct mi_asm_cache_struct
+{
+ mi_strtab *strs;
+ mi_asm_rec *recs;      /* Sorted by address. */
+ int nrecs, arecs;
+ mi_asm_range *ranges;  /* Disassembled ranges, sorted and disjoint. */
+ int nranges, aranges;
+};
+typedef struct mi_asm_cache_struct mi_asm_cache;
 
 /* Changed register. */
 struct mi_chg_reg_struct
@@ -333,6 +660,84 @@ struct mi_chg_reg_struct
 };
 typedef struct mi_chg_reg_struct mi_chg_reg;
 
+/* Trace frame, see tracepoint.c */
+enum mi_tfind_mode { tf_none=0, tf_frame=1, tf_tracepoint=2, tf_pc=3,
+                     tf_pc_inside=4, tf_pc_outside=5, tf_line=6 };
+
+struct mi_trace_frame_struct
+{
+ int traceframe;   /* -1 if not found. */
+ int tracepoint;
+ mi_frames *frame;
+ /* From -trace-frame-collected, lists of tuples as reported by gdb. */
+ mi_results *vars;   /* explicit-variables: name, value */
+ mi_results *exps;   /* computed-expressions: name, value */
+ mi_results *tvars;  /* name, current */
+ mi_results *memory; /* address, length, contents */
+ mi_chg_reg *regs;
+ int nregs;
+
+ struct mi_trace_frame_struct *next;
+};
+typedef struct mi_trace_frame_struct mi_trace_frame;
+
+/* Register names, shared by all the sessions. See regfile.c */
+struct mi_reg_names_struct
+{
+ char *key;     /* Architecture, NULL if not in the cache. */
+ int count;
+ char **names;  /* Indexed by register number, NULL if unnamed. */
+ char *names_blk;
+ int refs;
+
+ struct mi_reg_names_struct *next;
+};
+typedef struct mi_reg_names_struct mi_reg_names;
+
+/* Register file: registers indexed by number. See regfile.c */
+struct mi_regfile_struct
+{
+ int count;     /* Number of registers. */
+ char **names;  /* Indexed by register number, NULL if unnamed. */
+ mi_reg_names *rnames;
+ enum mi_gvar_fmt fmt;
+ /* Values, stored in the arena. Use mi_regfile_value. */
+ int *val_off;  /* -1 if unknown. */
+ int *val_len;
+ char *arena;
+ int arena_size, arena_used, arena_waste;
+ /* Registers changed in the last update. */
+ int *changed;
+ int nchanged;
+ char *updated; /* Indexed by register number. */
+};
+typedef struct mi_regfile_struct mi_regfile;
+
+/* Stop snapshot, see snapshot.c */
+#define MI_SNAP_FRAME    1
+#define MI_SNAP_ARGS     2
+#define MI_SNAP_LOCALS   4
+#define MI_SNAP_CHANGED  8
+#define MI_SNAP_REGS     16
+#define MI_SNAP_THREADS  32
+#define MI_SNAP_ALL      63
+
+struct mi_snapshot_struct
+{
+ unsigned stop_gen; /* Stop where it was taken. */
+ unsigned have;     /* MI_SNAP_* parts we got. */
+ mi_frames *frame;  /* Current frame, including its arguments. */
+ mi_results *args;  /* Only if we didn't get the frame. */
+ mi_results *locals;
+ mi_chg_reg *changed; /* Numbers of the registers that changed. */
+ int nchanged;
+ mi_chg_reg *regs;  /* All the registers, updated set if changed. */
+ int nregs;
+ int *threads;      /* Thread ids. */
+ int nthreads;
+};
+typedef struct mi_snapshot_struct mi_snapshot;
+
 /*
  Examining gdb sources and looking at docs I can see the following "stop"
 reasons:
@@ -402,6 +807,72 @@ struct mi_stop_struct
 };
 typedef struct mi_stop_struct mi_stop;
 
+/* Step trace recorder, see step_trace.c */
+enum mi_step_mode { sm_stepi=0, sm_nexti=1, sm_step=2, sm_next=3 };
+
+struct mi_step_mem_struct
+{
+ char *exp;     /* Address of the range. */
+ int len;
+ unsigned long addr;
+ unsigned char *data, *tmp;
+ char state;    /* 0 not available, 1 same as last step, 2 new data. */
+ struct mi_step_mem_struct *next;
+};
+typedef struct mi_step_mem_struct mi_step_mem;
+
+struct mi_step_trace_struct
+{
+ FILE *f;
+ char header;      /* Already written/read. */
+ int count;        /* Registers recorded. */
+ int *regs;        /* Their numbers. */
+ int stride, big_endian;
+ /* Values in slots of stride bytes, sizes is -1 if unavailable. */
+ unsigned char *vals, *prev;
+ int *sizes, *psizes;
+ int *changed;     /* Slots changed in the last step. */
+ int nchanged;
+ unsigned long long pc;
+ mi_step_mem *mems;
+ int nmems;
+ unsigned steps;
+ enum mi_stop_reason reason; /* Why the last recording stopped. */
+};
+typedef struct mi_step_trace_struct mi_step_trace;
+/* Called after each step, 0 stops the recording. */
+typedef int (*mi_step_cb)(mi_step_trace *t, void *data);
+
+/* A decoded =notify record. */
+struct mi_event_struct
+{
+ int type;              /* MI_CL_* */
+ char have_exit_code;
+ /* Thread or breakpoint number. */
+ int id;
+ /* Thread group, i.e. "i1". */
+ char *group_id;
+ /* thread-group-started */
+ int pid;
+ /* thread-group-exited */
+ int exit_code;
+ /* thread-selected */
+ mi_frames *frame;
+ /* library-*: id, target and host names. */
+ char *name;
+ char *target_name;
+ char *host_name;
+ char symbols_loaded;
+ /* breakpoint-created/modified */
+ mi_bkpt *bkpt;
+ /* cmd-param-changed: name is the parameter. */
+ char *value;
+ /* memory-changed */
+ void *addr;
+ int len;
+};
+typedef struct mi_event_struct mi_event;
+
 /* Variable containing the last error. */
 extern int mi_error;
 extern char *mi_error_from_gdb;
@@ -439,6 +910,11 @@ stream_cb mi_get_log_cb(mi_h *h, void **data);
 /* The callback to deal with async events. */
 void mi_set_async_cb(mi_h *h, async_cb cb, void *data);
 async_cb mi_get_async_cb(mi_h *h, void **data);
+/* The callback for decoded notifications and which ones we want. */
+void mi_set_event_cb(mi_h *h, event_cb cb, void *data);
+event_cb mi_get_event_cb(mi_h *h, void **data);
+void mi_set_notify_mask(mi_h *h, unsigned mask);
+unsigned mi_get_notify_mask(mi_h *h);
 /* Time out in gdb responses. */
 void mi_set_time_out_cb(mi_h *h, tm_cb cb, void *data);
 tm_cb mi_get_time_out_cb(mi_h *h, void **data);
@@ -451,6 +927,38 @@ stream_cb mi_get_to_gdb_cb(mi_h *h, void **data);
 stream_cb mi_get_from_gdb_cb(mi_h *h, void **data);
 /* Sends a message to gdb. */
 int mi_send(mi_h *h, const char *format, ...);
+/* Pipelined dialog: send up to "depth" commands before reading responses. */
+typedef void (*mi_pl_send_cb)(mi_h *h, int index, void *data);
+typedef int  (*mi_pl_recv_cb)(mi_h *h, int index, void *data);
+int mi_pipeline(mi_h *h, int count, mi_pl_send_cb snd, mi_pl_recv_cb rcv,
+                void *data);
+void mi_set_pipeline_depth(mi_h *h, int depth);
+int mi_get_pipeline_depth(mi_h *h);
+/* Stop generation, changes each time the target resumes or stops. */
+unsigned mi_get_stop_gen(mi_h *h);
+/* Forget all the information cached for the current stop. */
+void mi_invalidate_caches(mi_h *h);
+void mi_selection_changed(mi_h *h, int thread);
+/* Run state of the threads, updated from the async records. */
+int mi_get_thread_state(mi_h *h, int id);
+const mi_thread_state *mi_get_thread_states(mi_h *h, int *count);
+/* Async records received while waiting for a result (non-stop). */
+int mi_get_kept_async(mi_h *h);
+/* Blocks until the target stops, also for non-stop mode. */
+mi_output *mi_get_stop_blk(mi_h *h);
+/* Read and parse the gdb output in a separated thread. */
+int mi_start_reader(mi_h *h);
+void mi_stop_reader(mi_h *h);
+int mi_reader_eof(mi_h *h);
+/* What to wait for in an event loop. */
+int mi_get_read_fd(mi_h *h);
+/* Breakpoint hit statistics. */
+int mi_enable_hit_stats(mi_h *h, int enable);
+void mi_hit_stats_reset(mi_h *h);
+mi_bkpt_hits *mi_get_bkpt_hits(mi_h *h, int number);
+mi_bkpt_hits *mi_get_all_bkpt_hits(mi_h *h, int *count);
+unsigned long long mi_bkpt_hits_interval(mi_bkpt_hits *b);
+void mi_hit_stats_merge(mi_h *h, mi_bkpt *b);
 /* Wait until gdb sends a response. */
 mi_output *mi_get_response_blk(mi_h *h);
 /* Check if gdb sent a complete response. Use with mi_retire_response. */
@@ -459,11 +967,15 @@ int mi_get_response(mi_h *h);
 mi_output *mi_retire_response(mi_h *h);
 /* Look for a result record in gdb output. */
 mi_output *mi_get_rrecord(mi_output *r);
+/* Look for a *stopped record in gdb output. */
+mi_output *mi_get_stop_record(mi_output *r);
 /* Look if the output contains an async stop.
    If that's the case return the reason for the stop.
    If the output contains an error the description is returned in reason. */
 int mi_get_async_stop_reason(mi_output *r, char **reason);
 mi_stop *mi_get_stopped(mi_results *r);
+int mi_get_async_class(const char *str, const char **end);
+mi_event *mi_get_event(mi_output *o);
 mi_frames *mi_get_async_frame(mi_output *r);
 /* Wait until gdb sends a response.
    Then check if the response is of the desired type. */
@@ -477,6 +989,7 @@ mi_results *mi_res_done_var(mi_h *h, const char *var);
 mi_frames *mi_res_frames_array(mi_h *h, const char *var);
 mi_frames *mi_res_frames_list(mi_h *h);
 mi_frames *mi_parse_frame(mi_results *c);
+mi_thread *mi_parse_thread(mi_results *c);
 mi_frames *mi_res_frame(mi_h *h);
 /* Create an auxiliar terminal using xterm. */
 mi_aux_term *gmi_start_xterm();
@@ -495,6 +1008,7 @@ void gmi_end_pty(mi_pty *p);
 mi_pty *gmi_look_for_free_pty();
 /* Extract a list of thread IDs from response. */
 int mi_res_thread_ids(mi_h *h, int **list);
+mi_thread *mi_res_thread_info(mi_h *h, int *current);
 int mi_get_thread_ids(mi_output *res, int **list);
 /* A variable response. */
 mi_gvar *mi_res_gvar(mi_h *h, mi_gvar *cur, const char *expression);
@@ -506,6 +1020,7 @@ const char *mi_lang_enum_to_str(enum mi_gvar_lang lang);
 int mi_res_changelist(mi_h *h, mi_gvar_chg **changed);
 int mi_res_children(mi_h *h, mi_gvar *v);
 mi_bkpt *mi_res_bkpt(mi_h *h);
+mi_bkpt *mi_res_break_list(mi_h *h);
 mi_wp *mi_res_wp(mi_h *h);
 char *mi_res_value(mi_h *h);
 mi_stop *mi_res_stop(mi_h *h);
@@ -536,9 +1051,11 @@ mi_gvar_chg      *mi_alloc_gvar_chg(void);
 mi_bkpt          *mi_alloc_bkpt(void);
 mi_wp            *mi_alloc_wp(void);
 mi_stop          *mi_alloc_stop(void);
+mi_event         *mi_alloc_event(void);
 mi_asm_insns     *mi_alloc_asm_insns(void);
 mi_asm_insn      *mi_alloc_asm_insn(void);
 mi_chg_reg       *mi_alloc_chg_reg(void);
+mi_thread        *mi_alloc_thread(void);
 void mi_free_output(mi_output *r);
 void mi_free_output_but(mi_output *r, mi_output *no, mi_results *no_r);
 void mi_free_frames(mi_frames *f);
@@ -549,10 +1066,19 @@ void mi_free_gvar(mi_gvar *v);
 void mi_free_gvar_chg(mi_gvar_chg *p);
 void mi_free_wp(mi_wp *wp);
 void mi_free_stop(mi_stop *s);
+void mi_free_event(mi_event *e);
 void mi_free_asm_insns(mi_asm_insns *i);
 void mi_free_asm_insn(mi_asm_insn *i);
 void mi_free_charp_list(char **l);
 void mi_free_chg_reg(mi_chg_reg *r);
+void mi_free_threads(mi_thread *t);
+void mi_free_eval_cache(mi_eval_cache *c);
+void mi_free_regfile(mi_regfile *rf);
+void mi_free_backtrace(mi_backtrace *bt);
+void mi_free_strtab(mi_strtab *t);
+void mi_free_profile(mi_profile *p);
+void mi_free_frame_store(mi_frame_store *fs);
+void mi_free_snapshot(mi_snapshot *s);
 
 /* Porgram control: */
 /* Specify the executable and arguments for local debug. */
@@ -589,6 +1115,14 @@ int gmi_exec_until_addr(mi_h *h, void *addr);
 mi_frames *gmi_exec_return(mi_h *h);
 /* Just kill the program. Please read the notes in prg_control.c. */
 int gmi_exec_kill(mi_h *h);
+/* Non-stop mode, gdb 7.0 or newer. Use before starting the program. */
+int gmi_set_non_stop(mi_h *h, int on);
+/* Exec commands for one thread, MI_ALL_THREADS for all. For non-stop mode. */
+int gmi_exec_continue_thread(mi_h *h, int thread);
+int gmi_exec_interrupt_thread(mi_h *h, int thread);
+int gmi_exec_next_thread(mi_h *h, int thread);
+int gmi_exec_step_thread(mi_h *h, int thread);
+int gmi_exec_finish_thread(mi_h *h, int thread);
 
 /* Target manipulation: */
 /* Connect to a remote gdbserver using the specified methode. */
@@ -630,10 +1164,82 @@ int gmi_break_set_condition(mi_h *h, int number, const char *condition);
 int gmi_break_state(mi_h *h, int number, int enable);
 /* Set a watchpoint. It doesn't work for remote targets! */
 mi_wp *gmi_break_watch(mi_h *h, enum mi_wp_mode mode, const char *exp);
+/* Dynamic printf, doesn't stop the target. */
+mi_bkpt *gmi_dprintf_insert(mi_h *h, int temporary, const char *cond,
+                            int count, int thread, const char *where,
+                            const char *format, const char **args,
+                            int nargs);
+/* Where the conditions are evaluated, gdb 7.5 or newer. */
+int gmi_break_set_cond_eval(mi_h *h, enum mi_cond_eval mode);
+mi_bkpt *gmi_break_list(mi_h *h);
+/* Commands executed when hit, actions for tracepoints. */
+int gmi_break_commands(mi_h *h, int number, const char **cmds, int count);
+/* Tracepoints. */
+mi_bkpt *gmi_trace_insert(mi_h *h, const char *cond, const char *where);
+int gmi_trace_start(mi_h *h);
+int gmi_trace_stop(mi_h *h);
+mi_trace_frame *gmi_trace_find(mi_h *h, enum mi_tfind_mode mode,
+                               const char *arg);
+int gmi_trace_frame_collected(mi_h *h, mi_trace_frame *f);
+mi_trace_frame *gmi_trace_get_frames(mi_h *h, int first, int count);
+void mi_free_trace_frame(mi_trace_frame *f);
+/* Step trace recorder. */
+mi_step_trace *mi_new_step_trace(FILE *f, const int *regs, int count,
+                                 int stride, int big_endian);
+void mi_free_step_trace(mi_step_trace *t);
+int mi_step_trace_add_mem(mi_step_trace *t, const char *exp, int len);
+int gmi_step_trace_run(mi_h *h, mi_step_trace *t, enum mi_step_mode mode,
+                       int steps, mi_step_cb cb, void *data);
+mi_step_trace *mi_step_trace_open(FILE *f);
+int mi_step_trace_next(mi_step_trace *t);
+/* Breakpoint table indexed by number and location. */
+mi_bkpt_tab *mi_new_bkpt_tab();
+void mi_free_bkpt_tab(mi_bkpt_tab *t);
+mi_bkpt *mi_bkpt_tab_find(mi_bkpt_tab *t, int number);
+mi_bkpt *mi_bkpt_tab_find_loc(mi_bkpt_tab *t, const char *file, int line);
+mi_bkpt *mi_bkpt_tab_find_addr(mi_bkpt_tab *t, void *addr);
+void mi_bkpt_tab_add(mi_bkpt_tab *t, mi_bkpt *b);
+void mi_bkpt_tab_remove(mi_bkpt_tab *t, mi_bkpt *b);
+int mi_bkpt_tab_event(mi_bkpt_tab *t, mi_event *e);
+int mi_bkpt_where(mi_bkpt *b, char *buf, int size);
+/* Bulk operations, using a pipeline. */
+int gmi_bkpt_tab_insert(mi_h *h, mi_bkpt_tab *t, mi_bkpt *reqs);
+int gmi_bkpt_tab_delete(mi_h *h, mi_bkpt_tab *t, int *numbers, int count);
+int gmi_bkpt_tab_enable(mi_h *h, mi_bkpt_tab *t, int *numbers, int count,
+                        int enable);
+/* Session state: save and restore. */
+mi_session *mi_new_session();
+void mi_free_session(mi_session *s);
+int mi_session_set_path(mi_session *s, const char *path);
+mi_bkpt *mi_session_add_bkpt(mi_session *s, mi_bkpt *b);
+int mi_session_add_bkpt_tab(mi_session *s, mi_bkpt_tab *t);
+mi_wp *mi_session_add_wp(mi_session *s, enum mi_wp_mode mode,
+                         const char *exp, int enabled);
+int mi_session_add_exp(mi_session *s, const char *exp);
+int mi_session_save(mi_session *s, FILE *f);
+mi_session *mi_session_load(FILE *f);
+int gmi_session_restore(mi_h *h, mi_session *s, mi_bkpt_tab *t,
+                        mi_var_reg *r);
+/* Hardware watchpoints manager. */
+mi_watch_man *mi_new_watch_man(int slots, int max_len);
+mi_watch_man *mi_new_watch_man_arch(const char *arch);
+void mi_free_watch_man(mi_watch_man *m);
+int mi_watch_man_split(mi_watch_man *m, void *addr, int len, int exact,
+                       void **addrs, int *lens, int max);
+int gmi_watch_man_range(mi_h *h, mi_watch_man *m, void *addr, int len,
+                        enum mi_wp_mode mode, int flags);
+int gmi_watch_man_release(mi_h *h, mi_watch_man *m, void *addr, int len,
+                          enum mi_wp_mode mode, int flags);
+int gmi_watch_man_exp(mi_h *h, mi_watch_man *m, const char *exp,
+                      enum mi_wp_mode mode, int flags, void **addr, int *len);
 
 /* Data Manipulation. */
 /* Evaluate an expression. Returns a parsed tree. */
 char *gmi_data_evaluate_expression(mi_h *h, const char *expression);
+/* Evaluate a group of expressions using a pipeline and a per-stop cache. */
+int gmi_data_evaluate_expressions(mi_h *h, int count, const char **exps,
+                                  int thread, int frame, char **values,
+                                  char **errors);
 /* Path for sources. */
 int gmi_dir(mi_h *h, const char *path);
 /* A very limited "data read memory" implementation. */
@@ -644,12 +1250,48 @@ mi_asm_insns *gmi_data_disassemble_se(mi_h *h, const char *start,
                                       const char *end, int mode);
 mi_asm_insns *gmi_data_disassemble_fl(mi_h *h, const char *file, int line,
                                       int lines, int mode);
+/* Big ranges, in pipelined chunks. */
+int gmi_data_disassemble_stream(mi_h *h, void *start, void *end, int chunk,
+                                mi_asm_cb cb, void *data);
+/* Disassembly cache. */
+mi_asm_cache *mi_new_asm_cache();
+void mi_free_asm_cache(mi_asm_cache *c);
+void mi_asm_cache_flush(mi_asm_cache *c);
+int mi_asm_cache_add(mi_asm_cache *c, void *start, void *end, mi_asm_insn *ins);
+int mi_asm_cache_invalidate(mi_asm_cache *c, void *addr, int len);
+int mi_asm_cache_event(mi_asm_cache *c, mi_event *e);
+int mi_asm_cache_find(mi_asm_cache *c, void *addr);
+int mi_asm_cache_range_of(mi_asm_cache *c, int index, int *first, int *last);
+const char *mi_asm_cache_func(mi_asm_cache *c, mi_asm_rec *r);
+const char *mi_asm_cache_inst(mi_asm_cache *c, mi_asm_rec *r);
+int gmi_asm_cache_fetch(mi_h *h, mi_asm_cache *c, void *start, void *end);
 mi_chg_reg *gmi_data_list_register_names(mi_h *h, int *how_many);
 int gmi_data_list_register_names_l(mi_h *h, mi_chg_reg *l);
 mi_chg_reg *gmi_data_list_changed_registers(mi_h *h);
 int gmi_data_list_register_values(mi_h *h, enum mi_gvar_fmt fmt, mi_chg_reg *l);
 mi_chg_reg *gmi_data_list_all_register_values(mi_h *h, enum mi_gvar_fmt fmt, int *how_many);
 
+/* Register file. */
+/* Create a register file for the current target, names are filled. */
+mi_regfile *gmi_regfile_create(mi_h *h, enum mi_gvar_fmt fmt);
+mi_regfile *gmi_regfile_create_key(mi_h *h, enum mi_gvar_fmt fmt,
+                                   const char *key);
+/* Register values decoded as binary. */
+int gmi_data_list_register_values_raw(mi_h *h, const int *regs, int count,
+                                      unsigned char *buf, int stride,
+                                      int *sizes, int big_endian);
+/* Register names cache. */
+mi_reg_names *gmi_reg_names_get(mi_h *h, const char *key);
+void mi_reg_names_release(mi_reg_names *rn);
+void mi_reg_names_flush();
+mi_chg_reg *mi_reg_names_to_chg_reg(mi_reg_names *rn, int *how_many);
+/* Read the values of all the registers. */
+int gmi_regfile_read_all(mi_h *h, mi_regfile *rf);
+/* Update the values of the registers that changed. */
+int gmi_regfile_update(mi_h *h, mi_regfile *rf);
+/* Value of a register, NULL if unknown. */
+const char *mi_regfile_value(mi_regfile *rf, int reg);
+
 /* Stack manipulation. */
 /* List of frames. Arguments aren't filled. */
 mi_frames *gmi_stack_list_frames(mi_h *h);
@@ -669,6 +1311,36 @@ int gmi_stack_info_depth(mi_h *h, int max_depth);
 int gmi_stack_select_frame(mi_h *h, int framenum);
 /* List of local vars. */
 mi_results *gmi_stack_list_locals(mi_h *h, int show);
+/* Paged backtrace. */
+mi_backtrace *mi_new_backtrace(int page, int max_depth, int args);
+int gmi_backtrace_fetch(mi_h *h, mi_backtrace *bt, int from, int to);
+mi_frames *gmi_backtrace_frame(mi_h *h, mi_backtrace *bt, int level);
+int gmi_backtrace_depth(mi_h *h, mi_backtrace *bt);
+
+/* Stop snapshot. */
+mi_snapshot *gmi_snapshot(mi_h *h, unsigned what, enum mi_gvar_fmt fmt);
+
+/* String table. */
+mi_strtab *mi_new_strtab();
+int mi_strtab_intern(mi_strtab *t, const char *s);
+int mi_strtab_find(mi_strtab *t, const char *s);
+const char *mi_strtab_str(mi_strtab *t, int id);
+
+/* Frame store. */
+mi_frame_store *mi_new_frame_store(mi_strtab *strs);
+int mi_frame_store_add(mi_frame_store *fs, mi_frames *f);
+int mi_frame_store_depth(mi_frame_store *fs, int stack);
+mi_frame_rec *mi_frame_store_frame(mi_frame_store *fs, int stack, int level);
+mi_frames *mi_frame_store_get(mi_frame_store *fs, int stack);
+
+/* Sampling profiler. */
+mi_profile *mi_new_profile(int max_depth);
+int mi_profile_add_stack(mi_profile *p, mi_frames *f);
+/* Take a sample from a running target. */
+int gmi_profile_sample(mi_h *h, mi_profile *p);
+int gmi_profile_sample_stopped(mi_h *h, mi_profile *p);
+int gmi_profile_run(mi_h *h, mi_profile *p, int samples, int interval);
+int mi_profile_write_folded(mi_profile *p, FILE *f);
 
 /* Thread. */
 /* List available thread ids. */
@@ -677,6 +1349,11 @@ int gmi_thread_list_ids(mi_h *h, int **list);
 mi_frames *gmi_thread_select(mi_h *h, int id);
 /* List available threads. */
 mi_frames *gmi_thread_list_all_threads(mi_h *h);
+/* Information about all the threads, gdb 7.0 or newer. */
+mi_thread *gmi_thread_info(mi_h *h, int *current);
+/* Stacks for a list of threads, using a pipeline. */
+int gmi_thread_list_stacks(mi_h *h, mi_thread *l, int max_depth);
+mi_thread *gmi_thread_all_stacks(mi_h *h, int max_depth, int *current);
 
 /* Variable objects. */
 /* Create a variable object. */
@@ -703,12 +1380,36 @@ int gmi_var_show_attributes(mi_h *h, mi_gvar *var);
 /* Update variable. Use NULL for all.
    Note that *changed can be NULL if none updated. */
 int gmi_var_update(mi_h *h, mi_gvar *var, mi_gvar_chg **changed);
+/* The same, but also get the new values. */
+int gmi_var_update_values(mi_h *h, mi_gvar *var, int simple,
+                          mi_gvar_chg **changed);
 /* Change variable. Fills the value field. */
 int gmi_var_assign(mi_h *h, mi_gvar *var, const char *expression);
 /* Get current value for a variable. */
 int gmi_var_evaluate_expression(mi_h *h, mi_gvar *var);
 /* List children. It ONLY returns the first level information. :-( */
 int gmi_var_list_children(mi_h *h, mi_gvar *var);
+/* Expand a subtree, level by level using a pipeline. */
+int gmi_var_expand(mi_h *h, mi_gvar *var, int max_depth, int max_nodes);
+/* Registry of variable objects indexed by name. */
+mi_var_reg *mi_new_var_reg();
+void mi_free_var_reg(mi_var_reg *r);
+mi_gvar *mi_var_reg_find(mi_var_reg *r, const char *name);
+void mi_var_reg_add(mi_var_reg *r, mi_gvar *v);
+mi_gvar *gmi_var_reg_create(mi_h *h, mi_var_reg *r, int frame,
+                            const char *exp);
+int gmi_var_reg_delete(mi_h *h, mi_var_reg *r, mi_gvar *var);
+int gmi_var_reg_list_children(mi_h *h, mi_var_reg *r, mi_gvar *var);
+int gmi_var_reg_expand(mi_h *h, mi_var_reg *r, mi_gvar *var, int max_depth,
+                       int max_nodes);
+int gmi_var_reg_apply(mi_h *h, mi_var_reg *r, mi_gvar_chg *changed);
+int gmi_var_reg_update(mi_h *h, mi_var_reg *r);
+/* Children of huge arrays fetched by windows, gdb 7.1 or newer. */
+mi_child_cache *mi_new_child_cache(mi_gvar *var, int size, int budget);
+void mi_child_cache_flush(mi_child_cache *c);
+void mi_free_child_cache(mi_child_cache *c);
+int gmi_child_cache_fetch(mi_h *h, mi_child_cache *c, int from, int to);
+mi_gvar *gmi_child_cache_get(mi_h *h, mi_child_cache *c, int index);
 
 #ifdef __cplusplus
 };
@@ -757,8 +1458,28 @@ public:
  int Run();
  int Stop();
  int Poll(mi_stop *&rs);
+ /* Snapshot of the stopped target, see gmi_snapshot. */
+ void SetAutoSnapshot(unsigned what, enum mi_gvar_fmt fmt=fm_natural)
+   { snapWhat=what; snapFmt=fmt; }
+ const mi_snapshot *GetSnapshot();
  int Continue();
  int RunOrContinue();
+ /* Non-stop mode, see gmi_set_non_stop. */
+ int EnableNonStop();
+ int ThreadContinue(int thread)
+   { return ThreadExec(gmi_exec_continue_thread,thread); }
+ int ThreadInterrupt(int thread)
+   { return ThreadExec(gmi_exec_interrupt_thread,thread); }
+ int ThreadNext(int thread)
+   { return ThreadExec(gmi_exec_next_thread,thread); }
+ int ThreadStep(int thread)
+   { return ThreadExec(gmi_exec_step_thread,thread); }
+ int ThreadFinish(int thread)
+   { return ThreadExec(gmi_exec_finish_thread,thread); }
+ int ContinueAll() { return ThreadContinue(MI_ALL_THREADS); }
+ int InterruptAll() { return ThreadInterrupt(MI_ALL_THREADS); }
+ int ThreadState(int thread)
+   { return mi_get_thread_state(h,thread); }
  int Kill();
  mi_bkpt *Breakpoint(const char *file, int line);
  mi_bkpt *Breakpoint(const char *where, bool temporary=false, const char *cond=NULL,
@@ -774,7 +1495,112 @@ public:
      return 0;
   return gmi_break_set_times(h,b->number,b->ignore);
  }
+ int BreakpointsInsert(mi_bkpt_tab *t, mi_bkpt *reqs)
+ {
+  if (state!=target_specified && state!=stopped)
+     return -1;
+  return gmi_bkpt_tab_insert(h,t,reqs);
+ }
+ int BreakpointsDelete(mi_bkpt_tab *t, int *numbers, int count)
+ {
+  if (state!=target_specified && state!=stopped)
+     return -1;
+  return gmi_bkpt_tab_delete(h,t,numbers,count);
+ }
+ int BreakpointsEnable(mi_bkpt_tab *t, int *numbers, int count,
+                       bool enable=true)
+ {
+  if (state!=target_specified && state!=stopped)
+     return -1;
+  return gmi_bkpt_tab_enable(h,t,numbers,count,enable);
+ }
+ mi_bkpt *DPrintf(const char *where, const char *format,
+                  const char **args=NULL, int nargs=0, const char *cond=NULL,
+                  bool temporary=false)
+ {
+  if (state!=target_specified && state!=stopped)
+     return NULL;
+  return gmi_dprintf_insert(h,temporary,cond,-1,-1,where,format,args,nargs);
+ }
+ mi_bkpt *Tracepoint(const char *where, const char *cond=NULL)
+ {
+  if (state!=target_specified && state!=stopped)
+     return NULL;
+  return gmi_trace_insert(h,cond,where);
+ }
+ int SetCondEval(enum mi_cond_eval mode)
+ {
+  if (state==disconnected || state==running)
+     return -1;
+  return gmi_break_set_cond_eval(h,mode);
+ }
+ mi_bkpt *BreakList()
+ {
+  if (state==disconnected || state==running)
+     return NULL;
+  return gmi_break_list(h);
+ }
+ int BreakCommands(mi_bkpt *b, const char **cmds, int count)
+ {
+  if (state!=target_specified && state!=stopped)
+     return 0;
+  return gmi_break_commands(h,b->number,cmds,count);
+ }
+ int TraceStart()
+ {
+  if (state==disconnected)
+     return 0;
+  return gmi_trace_start(h);
+ }
+ int TraceStop()
+ {
+  if (state==disconnected)
+     return -1;
+  return gmi_trace_stop(h);
+ }
+ mi_trace_frame *TraceFind(enum mi_tfind_mode mode, const char *arg=NULL)
+ {
+  if (state!=stopped)
+     return NULL;
+  return gmi_trace_find(h,mode,arg);
+ }
+ mi_trace_frame *TraceFrames(int first, int count)
+ {
+  if (state!=stopped)
+     return NULL;
+  return gmi_trace_get_frames(h,first,count);
+ }
+ int StepTrace(mi_step_trace *t, int steps, enum mi_step_mode mode=sm_stepi,
+               mi_step_cb cb=NULL, void *data=NULL)
+ {
+  if (state!=stopped)
+     return -1;
+  return gmi_step_trace_run(h,t,mode,steps,cb,data);
+ }
+ int RestoreSession(mi_session *s, mi_bkpt_tab *t, mi_var_reg *r=NULL)
+ {
+  if (state!=target_specified && state!=stopped)
+     return -1;
+  return gmi_session_restore(h,s,t,r);
+ }
  mi_wp *Watchpoint(enum mi_wp_mode mode, const char *exp);
+ /* Hardware watchpoints, see watch_man.c */
+ mi_watch_man *NewWatchManager()
+   { return mi_new_watch_man_arch(GetArchKey()); }
+ int WatchRange(mi_watch_man *m, void *addr, int len,
+                enum mi_wp_mode mode=wm_write, int flags=0)
+ {
+  if (state!=target_specified && state!=stopped)
+     return -1;
+  return gmi_watch_man_range(h,m,addr,len,mode,flags);
+ }
+ int WatchRelease(mi_watch_man *m, void *addr, int len,
+                  enum mi_wp_mode mode=wm_write, int flags=0)
+ {
+  if (state!=target_specified && state!=stopped)
+     return -1;
+  return gmi_watch_man_release(h,m,addr,len,mode,flags);
+ }
  int WatchDelete(mi_wp *w);
  int RunToMain();
  int StepOver(bool inst=false);
@@ -784,7 +1610,31 @@ public:
  int FinishFun();
  mi_frames *ReturnNow();
  mi_frames *CallStack(bool args);
+ int Profile(mi_profile *p, int samples, int interval);
+ mi_backtrace *NewBacktrace(bool args=true, int page=MI_DEFAULT_BT_PAGE,
+                            int max_depth=MI_DEFAULT_BT_MAX_DEPTH)
+   { return mi_new_backtrace(page,max_depth,args ? 1 : -1); }
+ int FetchFrames(mi_backtrace *bt, int from, int to)
+ {
+  if (state!=stopped)
+     return -1;
+  return gmi_backtrace_fetch(h,bt,from,to);
+ }
+ mi_frames *GetFrame(mi_backtrace *bt, int level)
+ {
+  if (state!=stopped)
+     return NULL;
+  return gmi_backtrace_frame(h,bt,level);
+ }
+ int StackDepth(mi_backtrace *bt)
+ {
+  if (state!=stopped)
+     return -1;
+  return gmi_backtrace_depth(h,bt);
+ }
  char *EvalExpression(const char *exp);
+ int EvalExpressions(int count, const char **exps, char **values,
+                     int thread=-1, int frame=-1);
  char *ModifyExpression(char *exp, char *newVal);
  mi_gvar *AddgVar(const char *exp, int frame=-1)
  {
@@ -804,6 +1654,12 @@ public:
      return 0;
   return gmi_var_evaluate_expression(h,var);
  }
+ int ExpandgVar(mi_gvar *var, int max_depth, int max_nodes=0)
+ {
+  if (state!=stopped)
+     return -1;
+  return gmi_var_expand(h,var,max_depth,max_nodes);
+ }
  int GetChildgVar(mi_gvar *var)
  {
   if (state!=stopped)
@@ -830,12 +1686,36 @@ public:
      return 0;
   return gmi_var_set_format(h,var,format);
  }
+ int FetchChildren(mi_child_cache *c, int from, int to)
+ {
+  if (state!=stopped)
+     return -1;
+  return gmi_child_cache_fetch(h,c,from,to);
+ }
+ mi_gvar *GetChild(mi_child_cache *c, int index)
+ {
+  if (state!=stopped)
+     return NULL;
+  return gmi_child_cache_get(h,c,index);
+ }
+ int UpdateVarReg(mi_var_reg *r)
+ {
+  if (state!=stopped)
+     return -1;
+  return gmi_var_reg_update(h,r);
+ }
  int ListChangedgVar(mi_gvar_chg *&changed)
  {
   if (state!=stopped)
      return 0;
   return gmi_var_update(h,NULL,&changed);
  }
+ int ListChangedgVarValues(mi_gvar_chg *&changed, int simple=0)
+ {
+  if (state!=stopped)
+     return 0;
+  return gmi_var_update_values(h,NULL,simple,&changed);
+ }
  int AssigngVar(mi_gvar *var, const char *exp);
  int Send(const char *command);
  int Version()
@@ -870,6 +1750,12 @@ public:
      return 0;
   return gmi_thread_list_all_threads(h);
  }
+ mi_thread *ThreadStacks(int max_depth=-1, int *current=NULL)
+ {
+  if (state!=stopped)
+     return NULL;
+  return gmi_thread_all_stacks(h,max_depth,current);
+ }
  mi_frames *ThreadSelect(int id)
  {
   if (state!=stopped)
@@ -888,18 +1774,21 @@ public:
      return NULL;
   return gmi_data_disassemble_fl(h,file,line,lines,mode);
  }
- mi_chg_reg *GetRegisterNames(int *how_many)
+ int Disassemble(mi_asm_cache *c, void *start, void *end)
  {
-  if (state!=target_specified && state!=stopped)
-     return NULL;
-  return gmi_data_list_register_names(h,how_many);
+  if (state!=stopped)
+     return -1;
+  return gmi_asm_cache_fetch(h,c,start,end);
  }
- int GetRegisterNames(mi_chg_reg *chg)
+ int Disassemble(void *start, void *end, mi_asm_cb cb, void *data=NULL,
+                 int chunk=0)
  {
-  if (state!=target_specified && state!=stopped)
-     return 0;
-  return gmi_data_list_register_names_l(h,chg);
+  if (state!=stopped)
+     return -1;
+  return gmi_data_disassemble_stream(h,start,end,chunk,cb,data);
  }
+ mi_chg_reg *GetRegisterNames(int *how_many);
+ int GetRegisterNames(mi_chg_reg *chg);
  int GetRegisterValues(mi_chg_reg *chg)
  {
   if (state!=stopped)
@@ -925,9 +1814,37 @@ public:
   return chg;
  }
  int UpdateRegisters(mi_chg_reg *regs);
+ mi_regfile *CreateRegFile(enum mi_gvar_fmt fmt=fm_natural)
+ {
+  if (state!=stopped)
+     return NULL;
+  mi_regfile *rf=gmi_regfile_create_key(h,fmt,GetRegNamesKey());
+  if (rf && !gmi_regfile_read_all(h,rf))
+    {
+     mi_free_regfile(rf);
+     rf=NULL;
+    }
+  return rf;
+ }
+ int UpdateRegFile(mi_regfile *rf)
+ {
+  if (state!=stopped)
+     return -1;
+  return gmi_regfile_update(h,rf);
+ }
+ int GetRegisterValuesRaw(const int *regs, int count, unsigned char *buf,
+                          int stride, int *sizes)
+ {
+  if (state!=stopped)
+     return -1;
+  return gmi_data_list_register_values_raw(h,regs,count,buf,stride,sizes,
+                                           GetTargetEndian()==enBig);
+ }
 
  endianType GetTargetEndian();
  archType   GetTargetArchitecture();
+ const char *GetArchKey();
+ const char *GetRegNamesKey();
  eState GetState() { return state; }
 
  /* Some wrappers */
@@ -954,6 +1871,26 @@ public:
    { mi_set_log_cb(h,cb,data); }
  void SetAsyncCB(async_cb cb, void *data=NULL)
    { mi_set_async_cb(h,cb,data); }
+ void SetEventCB(event_cb cb, void *data=NULL, unsigned mask=MI_EV_ALL)
+   { mi_set_event_cb(h,cb,data); mi_set_notify_mask(h,mask); }
+ /* Parse the gdb output in another thread, see mi_start_reader. */
+ int StartReader()
+   { return state!=disconnected && mi_start_reader(h); }
+ int GetReadFD()
+   { return state!=disconnected ? mi_get_read_fd(h) : -1; }
+ /* Breakpoint hit statistics, see mi_enable_hit_stats. */
+ int EnableHitStats(bool enable=true)
+ {
+  if (state==disconnected)
+     return 0;
+  return mi_enable_hit_stats(h,enable);
+ }
+ mi_bkpt_hits *BreakHits(mi_bkpt *b)
+ {
+  if (state==disconnected)
+     return NULL;
+  return mi_get_bkpt_hits(h,b->number);
+ }
  void SetToGDBCB(stream_cb cb, void *data=NULL)
    { mi_set_to_gdb_cb(h,cb,data); }
  void SetFromGDBCB(stream_cb cb, void *data=NULL)
@@ -973,13 +1910,20 @@ protected:
  dMode mode;
  endianType targetEndian;
  archType targetArch;
+ char *archKey;
+ char *regsKey;
  bool  preRun;  // Remote targets starts running but outside main.
  mi_h *h;
  mi_aux_term *aux_tty;
  int waitingTempBkpt;
+ mi_snapshot *snap;
+ unsigned snapWhat;
+ enum mi_gvar_fmt snapFmt;
 
  int SelectTargetTTY(const char *exec, const char *args, const char *auxtty,
                      dMode m);
+ void UpdateNonStopState();
+ int ThreadExec(int (*cmd)(mi_h *, int), int thread);
 };
 
 #endif
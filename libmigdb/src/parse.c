@@ -29,6 +29,9 @@ tree (could be a complex one) that we can easily interpret using C code.
 #include <assert.h>
 #include "mi_gdb.h"
 
+/* From connect.c */
+void mi_set_error(int error);
+
 mi_results *mi_get_result(const char *str, const char **end);
 int mi_get_value(mi_results *r, const char *str, const char **end);
 
@@ -57,7 +60,7 @@ int mi_get_cstring_r(mi_results *r, const char *str, const char **end)
 
  if (*str!='"')
    {
-    mi_error=MI_PARSER;
+    mi_set_error(MI_PARSER);
     return 0;
    }
  str++;
@@ -68,7 +71,7 @@ int mi_get_cstring_r(mi_results *r, const char *str, const char **end)
        {
         if (!*s)
           {
-           mi_error=MI_PARSER;
+           mi_set_error(MI_PARSER);
            return 0;
           }
         s++;
@@ -124,7 +127,7 @@ char *mi_get_var_name(const char *str, const char **end)
  for (s=str; *s && mi_is_var_name_char(*s); s++);
  if (*s!='=')
    {
-    mi_error=MI_PARSER;
+    mi_set_error(MI_PARSER);
     return NULL;
    }
  /* Allocate. */
@@ -163,7 +166,7 @@ int mi_get_list_res(mi_results *r, const char *str, const char **end, char close
    }
  while (1);
 
- mi_error=MI_PARSER;
+ mi_set_error(MI_PARSER);
  return 0;
 }
 
@@ -199,7 +202,7 @@ int mi_get_tuple_val(mi_results *r, const char *str, const char **end)
    }
  while (1);
 
- mi_error=MI_PARSER;
+ mi_set_error(MI_PARSER);
  return 0;
 }
 #endif /* __APPLE__ */
@@ -208,7 +211,7 @@ int mi_get_tuple(mi_results *r, const char *str, const char **end)
 {
  if (*str!='{')
    {
-    mi_error=MI_PARSER;
+    mi_set_error(MI_PARSER);
     return 0;
    }
  r->type=t_tuple;
@@ -258,7 +261,7 @@ int mi_get_list_val(mi_results *r, const char *str, const char **end)
    }
  while (1);
 
- mi_error=MI_PARSER;
+ mi_set_error(MI_PARSER);
  return 0;
 }
 
@@ -266,7 +269,7 @@ int mi_get_list(mi_results *r, const char *str, const char **end)
 {
  if (*str!='[')
    {
-    mi_error=MI_PARSER;
+    mi_set_error(MI_PARSER);
     return 0;
    }
  r->type=t_list;
@@ -293,7 +296,7 @@ int mi_get_value(mi_results *r, const char *str, const char **end)
     case '[':
          return mi_get_list(r,str,end);
    }
- mi_error=MI_PARSER;
+ mi_set_error(MI_PARSER);
  return 0;
 }
 
@@ -335,7 +338,7 @@ mi_output *mi_get_results_alone(mi_output *r,const char *str)
        return r;
     if (*str!=',')
       {
-       mi_error=MI_PARSER;
+       mi_set_error(MI_PARSER);
        break;
       }
     str++;
@@ -385,31 +388,80 @@ mi_output *mi_parse_result_record(mi_output *r,const char *str)
    }
  else
    {
-    mi_error=MI_UNKNOWN_RESULT;
+    mi_set_error(MI_UNKNOWN_RESULT);
     return NULL;
    }
 
  return mi_get_results_alone(r,str);
 }
 
+/* Async classes, the notifications are at the end. */
+static struct
+{
+ const char *name;
+ int len;
+ char tclass;
+} mi_async_classes[]=
+{
+ {"stopped",7,MI_CL_STOPPED},
+ {"download",8,MI_CL_DOWNLOAD},
+ {"running",7,MI_CL_RUNNING},
+ {"thread-created",14,MI_CL_THREAD_CREATED},
+ {"thread-exited",13,MI_CL_THREAD_EXITED},
+ {"thread-group-added",18,MI_CL_THREAD_GROUP_ADDED},
+ {"thread-group-removed",20,MI_CL_THREAD_GROUP_REMOVED},
+ {"thread-group-started",20,MI_CL_THREAD_GROUP_STARTED},
+ {"thread-group-exited",19,MI_CL_THREAD_GROUP_EXITED},
+ {"thread-selected",15,MI_CL_THREAD_SELECTED},
+ {"library-loaded",14,MI_CL_LIBRARY_LOADED},
+ {"library-unloaded",16,MI_CL_LIBRARY_UNLOADED},
+ {"breakpoint-created",18,MI_CL_BREAKPOINT_CREATED},
+ {"breakpoint-modified",19,MI_CL_BREAKPOINT_MODIFIED},
+ {"breakpoint-deleted",18,MI_CL_BREAKPOINT_DELETED},
+ {"cmd-param-changed",17,MI_CL_CMD_PARAM_CHANGED},
+ {"memory-changed",14,MI_CL_MEMORY_CHANGED}
+};
+#define MI_ASYNC_CLASSES (sizeof(mi_async_classes)/sizeof(mi_async_classes[0]))
+
+/**[txh]********************************************************************
+
+  Description:
+  Finds the class of an async record, @var{str} points after the '*', '+'
+or '=' character. Is cheap, used to filter the records before parsing them.
+If @var{end} isn't NULL it gets a pointer to what follows the class name.
+
+  Return: The MI_CL_* value, MI_CL_UNKNOWN if we don't know it.
+
+***************************************************************************/
+
+int mi_get_async_class(const char *str, const char **end)
+{
+ unsigned i;
+ char c;
+
+ for (i=0; i<MI_ASYNC_CLASSES; i++)
+     if (strncmp(str,mi_async_classes[i].name,mi_async_classes[i].len)==0)
+       {
+        c=str[mi_async_classes[i].len];
+        if (c==',' || c==0 || c=='\n' || c=='\r')
+          {
+           if (end)
+              *end=str+mi_async_classes[i].len;
+           return mi_async_classes[i].tclass;
+          }
+       }
+ return MI_CL_UNKNOWN;
+}
+
 mi_output *mi_parse_asyn(mi_output *r,const char *str)
 {
  r->type=MI_T_OUT_OF_BAND;
  r->stype=MI_ST_ASYNC;
  /* async-class. */
- if (strncmp(str,"stopped",7)==0)
-   {
-    r->tclass=MI_CL_STOPPED;
-    str+=7;
-    return mi_get_results_alone(r,str);
-   }
- if (strncmp(str,"download",8)==0)
-   {
-    r->tclass=MI_CL_DOWNLOAD;
-    str+=8;
+ r->tclass=mi_get_async_class(str,&str);
+ if (r->tclass!=MI_CL_UNKNOWN)
     return mi_get_results_alone(r,str);
-   }
- mi_error=MI_UNKNOWN_ASYNC;
+ mi_set_error(MI_UNKNOWN_ASYNC);
  mi_free_output(r);
  return NULL;
 }
@@ -470,7 +522,7 @@ mi_output *mi_parse_gdb_output(const char *str)
  mi_output *r=mi_alloc_output();
  if (!r)
    {
-    mi_error=MI_OUT_OF_MEMORY;
+    mi_set_error(MI_OUT_OF_MEMORY);
     return NULL;
    }
  str++;
@@ -491,7 +543,7 @@ mi_output *mi_parse_gdb_output(const char *str)
     case '&':
          return mi_log_stream(r,str);
    }   
- mi_error=MI_PARSER;
+ mi_set_error(MI_PARSER);
  return NULL;
 }
 
@@ -814,6 +866,82 @@ int mi_res_thread_ids(mi_h *h, int **list)
  return ids;
 }
 
+mi_thread *mi_parse_thread(mi_results *c)
+{
+ mi_thread *t=mi_alloc_thread();
+
+ if (!t)
+    return NULL;
+ for (; c; c=c->next)
+    {
+     if (c->type==t_const)
+       {
+        if (strcmp(c->var,"id")==0)
+           t->id=atoi(c->v.cstr);
+        else if (strcmp(c->var,"target-id")==0)
+          {
+           t->target_id=c->v.cstr;
+           c->v.cstr=NULL;
+          }
+        else if (strcmp(c->var,"name")==0)
+          {
+           t->name=c->v.cstr;
+           c->v.cstr=NULL;
+          }
+        else if (strcmp(c->var,"state")==0)
+           t->running=strcmp(c->v.cstr,"running")==0;
+        else if (strcmp(c->var,"core")==0)
+           t->core=atoi(c->v.cstr);
+       }
+     else if (c->type==t_tuple && strcmp(c->var,"frame")==0 && !t->frame)
+        t->frame=mi_parse_frame(c->v.rs);
+    }
+ return t;
+}
+
+mi_thread *mi_res_thread_info(mi_h *h, int *current)
+{
+ mi_output *r, *res;
+ mi_results *l, *c;
+ mi_thread *first=NULL, *last=NULL, *t;
+
+ if (current)
+    *current=-1;
+ r=mi_get_response_blk(h);
+ res=mi_get_rrecord(r);
+ if (res && res->tclass==MI_CL_DONE)
+   {
+    l=mi_get_var(res,"threads");
+    if (l && l->type==t_list)
+      {
+       for (c=l->v.rs; c; c=c->next)
+          {
+           if (c->type!=t_tuple)
+              continue;
+           t=mi_parse_thread(c->v.rs);
+           if (!t)
+             {
+              mi_free_threads(first);
+              first=NULL;
+              break;
+             }
+           if (last)
+              last->next=t;
+           else
+              first=t;
+           last=t;
+          }
+      }
+    else
+       mi_set_error(MI_PARSER);
+    c=mi_get_var(res,"current-thread-id");
+    if (c && c->type==t_const && current)
+       *current=atoi(c->v.cstr);
+   }
+ mi_free_output(r);
+ return first;
+}
+
 enum mi_gvar_lang mi_lang_str_to_enum(const char *lang)
 {
  enum mi_gvar_lang lg=lg_unknown;
@@ -975,6 +1103,12 @@ mi_gvar *mi_get_gvar(mi_output *o, mi_gvar *cur, const char *expression)
          {
           res->format=mi_format_str_to_enum(r->v.cstr);
          }
+       else if (strcmp(r->var,"value")==0)
+         {/* New gdb versions include it. */
+          free(res->value);
+          res->value=r->v.cstr;
+          r->v.cstr=NULL;
+         }
        else if (strcmp(r->var,"attr")==0)
          { /* Note: gdb 6.1.1 have only this: */
           if (strcmp(r->v.cstr,"editable")==0)
@@ -1032,6 +1166,11 @@ mi_gvar_chg *mi_get_gvar_chg(mi_results *r)
             {
              n->new_num_children=atoi(r->v.cstr);
             }
+          else if (strcmp(r->var,"value")==0)
+            {
+             n->value=r->v.cstr;
+             r->v.cstr=NULL;
+            }
           // type_changed="false" is the default
          }
        r=r->next;
@@ -1113,6 +1252,11 @@ int mi_res_changelist(mi_h *h, mi_gvar_chg **changed)
             {
              n->new_num_children=atoi(r->v.cstr);
             }
+          else if (strcmp(r->var,"value")==0)
+            {
+             n->value=r->v.cstr;
+             r->v.cstr=NULL;
+            }
           // type_changed="false" is the default
          }
        r=r->next;
@@ -1246,6 +1390,20 @@ mi_bkpt *mi_get_bkpt(mi_results *p)
          {
           if (strcmp(p->v.cstr,"breakpoint")==0)
              res->type=t_breakpoint;
+          else if (strcmp(p->v.cstr,"hw breakpoint")==0)
+             res->type=t_hw;
+          else if (strcmp(p->v.cstr,"dprintf")==0)
+             res->type=t_dprintf;
+          else if (strcmp(p->v.cstr,"tracepoint")==0)
+             res->type=t_tracepoint;
+          else if (strcmp(p->v.cstr,"watchpoint")==0)
+             res->type=t_watchpoint;
+          else if (strcmp(p->v.cstr,"hw watchpoint")==0)
+             res->type=t_hw_watchpoint;
+          else if (strcmp(p->v.cstr,"read watchpoint")==0)
+             res->type=t_read_watchpoint;
+          else if (strcmp(p->v.cstr,"acc watchpoint")==0)
+             res->type=t_acc_watchpoint;
           else
              res->type=t_unknown;
          }
@@ -1283,6 +1441,8 @@ mi_bkpt *mi_get_bkpt(mi_results *p)
           res->cond=p->v.cstr;
           p->v.cstr=NULL;
          }
+       else if (strcmp(p->var,"evaluated-by")==0)
+          res->cond_target=strcmp(p->v.cstr,"target")==0;
       }
     p=p->next;
    }
@@ -1300,6 +1460,46 @@ mi_bkpt *mi_res_bkpt(mi_h *h)
  return b;
 }
 
+mi_bkpt *mi_res_break_list(mi_h *h)
+{
+ mi_results *r=mi_res_done_var(h,"BreakpointTable"), *c, *n;
+ mi_bkpt *first=NULL, *last=NULL, *b;
+
+ if (!r || r->type!=t_tuple)
+   {
+    mi_free_results(r);
+    return NULL;
+   }
+ for (c=r->v.rs; c; c=c->next)
+     if (c->var && strcmp(c->var,"body")==0 && c->type==t_list)
+        break;
+ for (c=c ? c->v.rs : NULL; c; c=c->next)
+    {
+     if (c->type!=t_tuple)
+        continue;
+     /* Old gdb versions report the locations as "1.1", "1.2", etc. */
+     for (n=c->v.rs; n; n=n->next)
+         if (n->var && n->type==t_const && strcmp(n->var,"number")==0)
+            break;
+     if (n && strchr(n->v.cstr,'.'))
+        continue;
+     b=mi_get_bkpt(c->v.rs);
+     if (!b)
+       {
+        mi_free_bkpt(first);
+        first=NULL;
+        break;
+       }
+     if (last)
+        last->next=b;
+     else
+        first=b;
+     last=b;
+    }
+ mi_free_results(r);
+ return first;
+}
+
 mi_wp *mi_get_wp(mi_results *p, enum mi_wp_mode m)
 {
  mi_wp *res=mi_alloc_wp();
@@ -1567,6 +1767,111 @@ mi_stop *mi_res_stop(mi_h *h)
  return stop;
 }
 
+/**[txh]********************************************************************
+
+  Description:
+  Decodes a =notify record, like =thread-group-started or
+=breakpoint-modified. The strings are moved from the record to the event.
+
+  Return: A new mi_event or NULL if @var{o} isn't a notification we know.
+Release it using @x{mi_free_event}.
+
+***************************************************************************/
+
+mi_event *mi_get_event(mi_output *o)
+{
+ mi_event *e;
+ mi_results *r;
+ char *end;
+
+ if (!o || o->type!=MI_T_OUT_OF_BAND || o->stype!=MI_ST_ASYNC ||
+     o->sstype!=MI_SST_NOTIFY || o->tclass==MI_CL_UNKNOWN)
+    return NULL;
+ e=mi_alloc_event();
+ if (!e)
+    return NULL;
+ e->type=o->tclass;
+ for (r=o->c; r; r=r->next)
+    {
+     if (r->type==t_const)
+       {
+        if (strcmp(r->var,"id")==0)
+          {
+           /* Libraries and thread groups use a name as id. */
+           if (e->type==MI_CL_LIBRARY_LOADED || e->type==MI_CL_LIBRARY_UNLOADED ||
+               (e->type>=MI_CL_THREAD_GROUP_ADDED &&
+                e->type<=MI_CL_THREAD_GROUP_EXITED))
+             {
+              e->name=r->v.cstr;
+              r->v.cstr=NULL;
+             }
+           else
+              e->id=atoi(r->v.cstr);
+          }
+        else if (strcmp(r->var,"group-id")==0 ||
+                 strcmp(r->var,"thread-group")==0)
+          {
+           e->group_id=r->v.cstr;
+           r->v.cstr=NULL;
+          }
+        else if (strcmp(r->var,"pid")==0)
+           e->pid=atoi(r->v.cstr);
+        else if (strcmp(r->var,"exit-code")==0)
+          {/* gdb reports it in octal. */
+           e->have_exit_code=1;
+           e->exit_code=strtol(r->v.cstr,&end,8);
+          }
+        else if (strcmp(r->var,"target-name")==0)
+          {
+           e->target_name=r->v.cstr;
+           r->v.cstr=NULL;
+          }
+        else if (strcmp(r->var,"host-name")==0)
+          {
+           e->host_name=r->v.cstr;
+           r->v.cstr=NULL;
+          }
+        else if (strcmp(r->var,"symbols-loaded")==0)
+           e->symbols_loaded=atoi(r->v.cstr);
+        else if (strcmp(r->var,"param")==0)
+          {
+           e->name=r->v.cstr;
+           r->v.cstr=NULL;
+          }
+        else if (strcmp(r->var,"value")==0)
+          {
+           e->value=r->v.cstr;
+           r->v.cstr=NULL;
+          }
+        else if (strcmp(r->var,"addr")==0)
+           e->addr=(void *)strtoul(r->v.cstr,&end,0);
+        else if (strcmp(r->var,"len")==0)
+           e->len=strtol(r->v.cstr,&end,0);
+       }
+     else if (r->type==t_tuple)
+       {
+        if (!e->bkpt && strcmp(r->var,"bkpt")==0)
+          {
+           e->bkpt=mi_get_bkpt(r->v.rs);
+           if (!e->bkpt)
+              break;
+          }
+        else if (!e->frame && strcmp(r->var,"frame")==0)
+          {
+           e->frame=mi_parse_frame(r->v.rs);
+           if (!e->frame)
+              break;
+          }
+       }
+    }
+ if (r)
+   {/* Out of memory */
+    mi_free_event(e);
+    return NULL;
+   }
+ return e;
+}
+
 int mi_get_read_memory(mi_h *h, unsigned char *dest, unsigned ws, int *na,
                        unsigned long *addr)
 {
@@ -1616,6 +1921,18 @@ int mi_get_read_memory(mi_h *h, unsigned char *dest, unsigned ws, int *na,
  return ok==2;
 }
 
+/* "55" or "48 83 ec 10" on x86, "e92d4800" on ARM. */
+static
+unsigned mi_opcodes_size(const char *s)
+{
+ unsigned digits=0;
+
+ for (; *s; s++)
+     if (isxdigit((unsigned char)*s))
+        digits++;
+ return digits/2;
+}
+
 mi_asm_insn *mi_parse_insn(mi_results *c)
 {
  mi_asm_insn *res=NULL, *cur=NULL;
@@ -1652,6 +1969,8 @@ mi_asm_insn *mi_parse_insn(mi_results *c)
                }
              else if (strcmp(sub->var,"offset")==0)
                 cur->offset=atoi(sub->v.cstr);
+             else if (strcmp(sub->var,"opcodes")==0)
+                cur->size=mi_opcodes_size(sub->v.cstr);
              else if (strcmp(sub->var,"inst")==0)
                {
                 cur->inst=sub->v.cstr;
@@ -1825,7 +2144,7 @@ int mi_parse_reg_values(mi_results *r, mi_chg_reg *l)
                {
                 if (atoi(c->v.cstr)!=l->reg)
                   {
-                   mi_error=MI_PARSER;
+                   mi_set_error(MI_PARSER);
                    return 0;
                   }
                }
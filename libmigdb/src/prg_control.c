@@ -173,6 +173,15 @@ void mi_exec_kill(mi_h *h)
  mi_send(h,"kill\n");
 }
 
+/* Exec commands for a thread or all, used in non-stop mode. */
+void mi_exec_thread(mi_h *h, const char *cmd, int thread)
+{
+ if (thread==MI_ALL_THREADS)
+    mi_send(h,"-exec-%s --all\n",cmd);
+ else
+    mi_send(h,"-exec-%s --thread %d\n",cmd,thread);
+}
+
 /* High level versions. */
 
 /**[txh]********************************************************************
@@ -466,3 +475,113 @@ int gmi_exec_kill(mi_h *h)
  return mi_res_simple_done(h);
 }
 
+
+/**[txh]********************************************************************
+
+  Description:
+  Enables or disables the non-stop mode. In this mode a thread can be
+stopped while the rest keep running. Must be used before starting the
+target. Needs gdb 7.0 or newer, for gdb older than 7.8 the target-async
+setting is used.
+
+  Command: -gdb-set non-stop + -gdb-set mi-async
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_set_non_stop(mi_h *h, int on)
+{
+ const char *v=on ? "on" : "off";
+
+ if (!gmi_gdb_set(h,"non-stop",v))
+    return 0;
+ if (!gmi_gdb_set(h,"mi-async",v) && !gmi_gdb_set(h,"target-async",v))
+    return 0;
+ /* The reader thread checks it. */
+ __atomic_store_n(&h->non_stop,on,__ATOMIC_RELAXED);
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Continues the execution of @var{thread}, MI_ALL_THREADS for all. For the
+non-stop mode.
+
+  Command: -exec-continue --thread/--all
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_exec_continue_thread(mi_h *h, int thread)
+{
+ mi_exec_thread(h,"continue",thread);
+ return mi_res_simple_running(h);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Stops @var{thread}, MI_ALL_THREADS for all. For the non-stop mode, the
+stop is reported using an async record.
+
+  Command: -exec-interrupt --thread/--all
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_exec_interrupt_thread(mi_h *h, int thread)
+{
+ mi_exec_thread(h,"interrupt",thread);
+ return mi_res_simple_done(h);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Next line of code for @var{thread}. For the non-stop mode.
+
+  Command: -exec-next --thread
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_exec_next_thread(mi_h *h, int thread)
+{
+ mi_exec_thread(h,"next",thread);
+ return mi_res_simple_running(h);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Next line of code for @var{thread}, get inside functions. For the
+non-stop mode.
+
+  Command: -exec-step --thread
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_exec_step_thread(mi_h *h, int thread)
+{
+ mi_exec_thread(h,"step",thread);
+ return mi_res_simple_running(h);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Continues @var{thread} until the current function returns. For the
+non-stop mode.
+
+  Command: -exec-finish --thread
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_exec_finish_thread(mi_h *h, int thread)
+{
+ mi_exec_thread(h,"finish",thread);
+ return mi_res_simple_running(h);
+}
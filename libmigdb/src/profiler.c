@@ -0,0 +1,406 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Sampling profiler.
+  Comments:
+  A "poor man's profiler". The running target is periodically interrupted,
+the stacks of all the threads are collected and the target is resumed.@p
+
+  To keep the target stopped as little as possible the stacks of all the
+threads are requested in a pipeline (@x{mi_pipeline}) using the --thread
+option (gdb 7.0 or newer), so we don't need to select each thread.@p
+
+  The samples aren't stored, they are accumulated in a call tree. The
+function names are interned in a string table (@x{mi_new_strtab}), so each
+tree node is just a few integers. Inclusive and exclusive counts are kept
+for each call path (tree node) and for each function. The tree can be
+written in the "folded stacks" format used by the flame graph tools, see
+@x{mi_profile_write_folded}.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "mi_gdb.h"
+
+#define MI_PROF_NODES     256
+#define MI_PROF_MAX_DEPTH 256
+
+/* From stack_man.c */
+void mi_stack_list_frames_t(mi_h *h, int thread, int from, int to);
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates an empty profile. Only the innermost @var{max_depth} frames of
+each stack are collected, use 0 for the default.
+
+  Return: A new profile or NULL on error. Release it using
+@x{mi_free_profile}.
+
+***************************************************************************/
+
+mi_profile *mi_new_profile(int max_depth)
+{
+ mi_profile *p=(mi_profile *)mi_calloc1(sizeof(mi_profile));
+
+ if (!p)
+    return NULL;
+ p->max_depth=max_depth>0 ? max_depth : MI_PROF_MAX_DEPTH;
+ p->names=mi_new_strtab();
+ p->nodes=(mi_prof_node *)mi_malloc(MI_PROF_NODES*sizeof(mi_prof_node));
+ p->tmp=(int *)mi_malloc(p->max_depth*sizeof(int));
+ if (!p->names || !p->nodes || !p->tmp)
+   {
+    mi_free_profile(p);
+    return NULL;
+   }
+ p->anodes=MI_PROF_NODES;
+ /* The root */
+ memset(p->nodes,0,sizeof(mi_prof_node));
+ p->nodes[0].func=p->nodes[0].parent=-1;
+ p->nodes[0].child=p->nodes[0].sibling=-1;
+ p->nnodes=1;
+ return p;
+}
+
+void mi_free_profile(mi_profile *p)
+{
+ if (!p)
+    return;
+ mi_free_strtab(p->names);
+ free(p->nodes);
+ free(p->fincl);
+ free(p->fexcl);
+ free(p->fstamp);
+ free(p->tmp);
+ free(p);
+}
+
+/* Returns the child of parent for func, creating it if needed. */
+static
+int mi_prof_child(mi_profile *p, int parent, int func)
+{
+ int n;
+ mi_prof_node *c;
+
+ for (n=p->nodes[parent].child; n>=0; n=p->nodes[n].sibling)
+     if (p->nodes[n].func==func)
+        return n;
+ if (p->nnodes>=p->anodes)
+   {
+    c=(mi_prof_node *)realloc(p->nodes,p->anodes*2*sizeof(mi_prof_node));
+    if (!c)
+      {
+       mi_error=MI_OUT_OF_MEMORY;
+       return -1;
+      }
+    p->nodes=c;
+    p->anodes*=2;
+   }
+ n=p->nnodes++;
+ c=p->nodes+n;
+ c->func=func;
+ c->parent=parent;
+ c->child=-1;
+ c->sibling=p->nodes[parent].child;
+ c->incl=c->excl=0;
+ p->nodes[parent].child=n;
+ return n;
+}
+
+/* Interns the name of the function for this frame. */
+static
+int mi_prof_func(mi_profile *p, mi_frames *f)
+{
+ char b[32];
+ const char *name=f->func;
+ int id;
+
+ if (!name)
+   {
+    sprintf(b,"%p",f->addr);
+    name=b;
+   }
+ id=mi_strtab_intern(p->names,name);
+ if (id>=p->afuncs)
+   {/* Make room for the per function counters. */
+    int n=p->names->size;
+    unsigned *i=(unsigned *)realloc(p->fincl,n*sizeof(unsigned));
+    unsigned *e=i ? (unsigned *)realloc(p->fexcl,n*sizeof(unsigned)) : NULL;
+    unsigned *s=e ? (unsigned *)realloc(p->fstamp,n*sizeof(unsigned)) : NULL;
+    if (i)
+       p->fincl=i;
+    if (e)
+       p->fexcl=e;
+    if (!s)
+      {
+       mi_error=MI_OUT_OF_MEMORY;
+       return -1;
+      }
+    p->fstamp=s;
+    memset(p->fincl+p->afuncs,0,(n-p->afuncs)*sizeof(unsigned));
+    memset(p->fexcl+p->afuncs,0,(n-p->afuncs)*sizeof(unsigned));
+    memset(p->fstamp+p->afuncs,0,(n-p->afuncs)*sizeof(unsigned));
+    p->afuncs=n;
+   }
+ return id;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Adds a stack to the profile. The @var{f} list starts with the innermost
+frame, as reported by gdb. Useful to add stacks obtained by other means.
+
+  Return: !=0 OK
+
+***************************************************************************/
+
+int mi_profile_add_stack(mi_profile *p, mi_frames *f)
+{
+ int n=0, node=0, i, id=-1;
+
+ for (; f && n<p->max_depth; f=f->next)
+    {
+     id=mi_prof_func(p,f);
+     if (id<0)
+        return 0;
+     p->tmp[n++]=id;
+    }
+ p->samples++;
+ p->nodes[0].incl++;
+ /* From the outermost. */
+ for (i=n-1; i>=0; i--)
+    {
+     id=p->tmp[i];
+     node=mi_prof_child(p,node,id);
+     if (node<0)
+        return 0;
+     p->nodes[node].incl++;
+     /* Recursive functions count once. */
+     if (p->fstamp[id]!=p->samples)
+       {
+        p->fstamp[id]=p->samples;
+        p->fincl[id]++;
+       }
+    }
+ p->nodes[node].excl++;
+ if (n)
+    p->fexcl[p->tmp[0]]++;
+ return 1;
+}
+
+typedef struct
+{
+ mi_profile *p;
+ int *ids;
+} mi_prof_batch;
+
+static
+void mi_prof_batch_send(mi_h *h, int i, void *data)
+{
+ mi_prof_batch *b=(mi_prof_batch *)data;
+ mi_stack_list_frames_t(h,b->ids[i],0,b->p->max_depth-1);
+}
+
+static
+int mi_prof_batch_recv(mi_h *h, int i, void *data)
+{
+ mi_frames *f=mi_res_frames_array(h,"stack");
+ int ok;
+
+ if (!f)
+    return 0;
+ ok=mi_profile_add_stack(((mi_prof_batch *)data)->p,f);
+ mi_free_frames(f);
+ return ok;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Adds the stacks of all the threads to the profile. The target must be
+stopped.
+
+  Command: -thread-list-ids + -stack-list-frames
+  Return: The number of stacks added or -1 on error.
+
+***************************************************************************/
+
+int gmi_profile_sample_stopped(mi_h *h, mi_profile *p)
+{
+ mi_prof_batch b;
+ mi_frames *f;
+ int n;
+
+ b.p=p;
+ b.ids=NULL;
+ n=gmi_thread_list_ids(h,&b.ids);
+ if (n<0)
+    return -1;
+ if (!n)
+   {/* Not a threaded program. */
+    f=gmi_stack_list_frames_r(h,0,p->max_depth-1);
+    if (!f)
+       return -1;
+    n=mi_profile_add_stack(p,f);
+    mi_free_frames(f);
+    return n ? 1 : -1;
+   }
+ n=mi_pipeline(h,n,mi_prof_batch_send,mi_prof_batch_recv,&b);
+ free(b.ids);
+ return n;
+}
+
+/* Waits until the target stops. */
+static
+int mi_prof_wait_stop(mi_h *h, mi_profile *p)
+{
+ mi_output *o, *sr;
+ mi_stop *st;
+
+ o=mi_get_stop_blk(h);
+ if (!o)
+    return 0;
+ sr=mi_get_stop_record(o);
+ st=mi_get_stopped(sr->c);
+ if (st && (st->reason==sr_exited_signalled ||
+     st->reason==sr_exited || st->reason==sr_exited_normally))
+    p->exited=1;
+ mi_free_stop(st);
+ mi_free_output(o);
+ return !p->exited;
+}
+
+static
+unsigned long long mi_prof_now()
+{
+ struct timespec ts;
+
+ /* Monotonic, the wall clock can jump. */
+ clock_gettime(CLOCK_MONOTONIC,&ts);
+ return (unsigned long long)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Takes one sample: interrupts the running target, adds the stacks of all
+the threads and resumes it. The stopped field indicates if the target was
+left stopped (i.e. because of an error) and the exited field is set if the
+target finished.
+
+  Command: -thread-list-ids + -stack-list-frames + -exec-continue
+  Return: The number of stacks added or -1 on error.
+
+***************************************************************************/
+
+int gmi_profile_sample(mi_h *h, mi_profile *p)
+{
+ unsigned long long t;
+ int n;
+
+ /* The time needed to stop it is also lost by the target. */
+ t=mi_prof_now();
+ gmi_exec_interrupt(h);
+ if (!mi_prof_wait_stop(h,p))
+    return -1;
+ p->stopped=1;
+ p->stops++;
+ n=gmi_profile_sample_stopped(h,p);
+ if (gmi_exec_continue(h))
+    p->stopped=0;
+ p->stopped_us+=mi_prof_now()-t;
+ return p->stopped ? -1 : n;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Takes @var{samples} samples, one every @var{interval} milliseconds. The
+target must be running. It stops if the target exits or on error, see
+@x{gmi_profile_sample}.
+
+  Return: The number of samples taken.
+
+***************************************************************************/
+
+int gmi_profile_run(mi_h *h, mi_profile *p, int samples, int interval)
+{
+ int i;
+
+ for (i=0; i<samples; i++)
+    {
+     usleep(interval*1000);
+     if (gmi_profile_sample(h,p)<0)
+        break;
+    }
+ return i;
+}
+
+/* Writes the call path for node. */
+static
+void mi_prof_write_path(mi_profile *p, int node, FILE *f)
+{
+ int n=0, i;
+
+ for (; node>0 && n<p->max_depth; node=p->nodes[node].parent)
+     p->tmp[n++]=p->nodes[node].func;
+ for (i=n-1; i>=0; i--)
+     fprintf(f,i ? "%s;" : "%s",mi_strtab_str(p->names,p->tmp[i]));
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Writes the profile in the "folded stacks" format, one line for each call
+path with exclusive samples: "main;foo;bar 12". This is the input for
+flamegraph.pl and similar tools.
+
+  Return: The number of lines written.
+
+***************************************************************************/
+
+int mi_profile_write_folded(mi_profile *p, FILE *f)
+{
+ int node=p->nodes[0].child, lines=0;
+
+ /* Depth first walk, without recursion. */
+ while (node>0)
+   {
+    if (p->nodes[node].excl)
+      {
+       mi_prof_write_path(p,node,f);
+       fprintf(f," %u\n",p->nodes[node].excl);
+       lines++;
+      }
+    if (p->nodes[node].child>=0)
+       node=p->nodes[node].child;
+    else
+      {
+       while (node>0 && p->nodes[node].sibling<0)
+          node=p->nodes[node].parent;
+       if (node>0)
+          node=p->nodes[node].sibling;
+      }
+   }
+ return lines;
+}
@@ -0,0 +1,367 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Reader thread.
+  Comments:
+  Optionally each handle can get a thread that reads the gdb output and
+parses the out of band records (streams and async records). They are
+passed to the application thread using a lock-free single producer/single
+consumer ring. This way a flood of console output is parsed while the
+application does something else.@p
+
+  The result records and the prompts are passed as raw lines, they are
+parsed by @x{mi_get_response} as usual, so the callers that want the raw
+^done line still work.@p
+
+  The application thread never touches the gdb pipe, it waits on a wake
+pipe, see @x{mi_get_read_fd}. The callbacks are always called from the
+application thread.@p
+
+  The reader doesn't use the global error of the application, the errors
+found while parsing go to its own slot. When gdb closes the pipe the reader tells it to the
+application (@x{mi_reader_eof}), so a waiter doesn't wait for the time out.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include "mi_gdb.h"
+
+/* Must be a power of 2. */
+#define MI_READER_RING  1024
+#define MI_READER_CHUNK 4096
+
+/* From connect.c */
+int mi_want_notify(mi_h *h, const char *str);
+void mi_set_error_slot(int *slot);
+
+typedef struct
+{
+ char *line;
+ mi_output *o;
+} mi_reader_item;
+
+struct mi_reader_struct
+{
+ pthread_t thread;
+ /* reader -> application and application -> reader. */
+ int wake[2];
+ int stop[2];
+ /* head is written by the reader, tail by the application. */
+ unsigned head, tail;
+ /* Set by the reader when gdb closes the pipe. */
+ int eof;
+ /* Errors found by the reader, mi_error belongs to the application. */
+ int error;
+ mi_reader_item ring[MI_READER_RING];
+ /* Partial line, only used by the reader. */
+ char *buf;
+ int size, used;
+};
+
+static
+void mi_reader_close_pipes(mi_reader *r)
+{
+ if (r->wake[0]>=0)
+   {
+    close(r->wake[0]);
+    close(r->wake[1]);
+   }
+ if (r->stop[0]>=0)
+   {
+    close(r->stop[0]);
+    close(r->stop[1]);
+   }
+}
+
+/* Waits until there is room in the ring, returns 0 if we must stop. */
+static
+int mi_reader_wait_room(mi_reader *r)
+{
+ struct pollfd p;
+
+ while (__atomic_load_n(&r->head,__ATOMIC_RELAXED)-
+        __atomic_load_n(&r->tail,__ATOMIC_ACQUIRE)>=MI_READER_RING)
+   {
+    p.fd=r->stop[0];
+    p.events=POLLIN;
+    if (poll(&p,1,1)>0)
+       return 0;
+   }
+ return 1;
+}
+
+/* If the pipe is full the application is already awake. */
+static
+void mi_reader_wake(mi_reader *r)
+{
+ char c=0;
+ ssize_t n=write(r->wake[1],&c,1);
+ (void)n;
+}
+
+static
+int mi_reader_push(mi_reader *r, char *line, mi_output *o)
+{
+ unsigned head;
+
+ if (!mi_reader_wait_room(r))
+   {
+    free(line);
+    mi_free_output(o);
+    return 0;
+   }
+ head=__atomic_load_n(&r->head,__ATOMIC_RELAXED);
+ r->ring[head & (MI_READER_RING-1)].line=line;
+ r->ring[head & (MI_READER_RING-1)].o=o;
+ __atomic_store_n(&r->head,head+1,__ATOMIC_RELEASE);
+ mi_reader_wake(r);
+ return 1;
+}
+
+/* Parses the out of band records, the rest is passed as is. */
+static
+int mi_reader_line(mi_h *h, mi_reader *r, const char *s, int len)
+{
+ char *line;
+ mi_output *o=NULL;
+ int echo=__atomic_load_n(&h->from_gdb_echo,__ATOMIC_RELAXED)!=NULL;
+
+ if (!len)
+    return 1;
+ if (*s=='=' && !echo && !mi_want_notify(h,s+1))
+    return 1;
+ line=(char *)malloc(len+1);
+ if (!line)
+    return 1;
+ memcpy(line,s,len);
+ line[len]=0;
+ if (*s=='~' || *s=='@' || *s=='&' ||
+     ((*s=='*' || *s=='+' || *s=='=') &&
+      mi_get_async_class(line+1,NULL)!=MI_CL_UNKNOWN))
+   {
+    o=mi_parse_gdb_output(line);
+    if (o && !echo)
+      {
+       free(line);
+       line=NULL;
+      }
+   }
+ return mi_reader_push(r,line,o);
+}
+
+static
+void *mi_reader_loop(void *data)
+{
+ mi_h *h=(mi_h *)data;
+ mi_reader *r=h->reader;
+ struct pollfd p[2];
+ int i, start, n;
+ char c;
+
+ mi_set_error_slot(&r->error);
+ p[0].fd=h->from_gdb[0];
+ p[1].fd=r->stop[0];
+ p[0].events=p[1].events=POLLIN;
+ while (1)
+   {
+    if (poll(p,2,-1)<0)
+       continue;
+    if (p[1].revents)
+       return NULL;
+    if (r->used+MI_READER_CHUNK>r->size)
+      {
+       char *b=(char *)realloc(r->buf,r->used+MI_READER_CHUNK);
+       if (!b)
+          break;
+       r->buf=b;
+       r->size=r->used+MI_READER_CHUNK;
+      }
+    n=read(h->from_gdb[0],r->buf+r->used,MI_READER_CHUNK);
+    if (n==0)
+       /* gdb died. */
+       break;
+    if (n<0)
+      {
+       if (errno==EINTR || errno==EAGAIN)
+          continue;
+       /* Any other error means we can't talk to gdb, as if it died. */
+       break;
+      }
+    start=0;
+    for (i=r->used; i<r->used+n; i++)
+       {
+        c=r->buf[i];
+        if (c=='\n')
+          {
+           int len=i-start;
+           if (len && r->buf[i-1]=='\r')
+              len--;
+           if (!mi_reader_line(h,r,r->buf+start,len))
+              return NULL;
+           start=i+1;
+          }
+       }
+    r->used+=n-start;
+    memmove(r->buf,r->buf+start,r->used);
+   }
+ /* We can't read anymore, wake up the application. */
+ __atomic_store_n(&r->eof,1,__ATOMIC_RELEASE);
+ mi_reader_wake(r);
+ return NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Starts a thread that reads and parses the gdb output. Call it just after
+connecting, when we aren't waiting for a response. It's stopped by
+@x{mi_disconnect}.
+
+  Return: !=0 OK
+
+***************************************************************************/
+
+int mi_start_reader(mi_h *h)
+{
+ mi_reader *r;
+
+ if (h->reader)
+    return 1;
+ r=(mi_reader *)mi_calloc1(sizeof(mi_reader));
+ if (!r)
+    return 0;
+ r->wake[0]=r->stop[0]=-1;
+ if (pipe(r->wake) || pipe(r->stop))
+   {
+    mi_error=MI_PIPE_CREATE;
+    mi_reader_close_pipes(r);
+    free(r);
+    return 0;
+   }
+ fcntl(r->wake[0],F_SETFL,O_NONBLOCK);
+ fcntl(r->wake[1],F_SETFL,O_NONBLOCK);
+ h->reader=r;
+ if (pthread_create(&r->thread,NULL,mi_reader_loop,h))
+   {
+    mi_error=MI_OUT_OF_MEMORY;
+    h->reader=NULL;
+    mi_reader_close_pipes(r);
+    free(r);
+    return 0;
+   }
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Stops the reader thread. The records already parsed are released.
+
+***************************************************************************/
+
+void mi_stop_reader(mi_h *h)
+{
+ mi_reader *r=h->reader;
+ unsigned i;
+ char c=0;
+
+ if (!r)
+    return;
+ if (write(r->stop[1],&c,1)==1)
+    pthread_join(r->thread,NULL);
+ for (i=r->tail; i!=r->head; i++)
+    {
+     free(r->ring[i & (MI_READER_RING-1)].line);
+     mi_free_output(r->ring[i & (MI_READER_RING-1)].o);
+    }
+ mi_reader_close_pipes(r);
+ free(r->buf);
+ free(r);
+ h->reader=NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the file descriptor that becomes readable when gdb sends something.
+When the reader thread is running is the wake pipe, otherwise is the pipe
+connected to gdb. Useful to integrate the handle in an event loop.
+
+  Return: The file descriptor.
+
+***************************************************************************/
+
+int mi_get_read_fd(mi_h *h)
+{
+ return h->reader ? h->reader->wake[0] : h->from_gdb[0];
+}
+
+/* Gets the next item from the ring. The raw line, if any, is moved to
+   h->line. Returns 0 if the ring is empty, 1 for a line and 2 for a parsed
+   record without the line. */
+int mi_reader_get(mi_h *h, mi_output **o)
+{
+ mi_reader *r=h->reader;
+ mi_reader_item *it;
+ unsigned tail=r->tail;
+ int ret=2;
+ char b[64];
+
+ if (__atomic_load_n(&r->head,__ATOMIC_ACQUIRE)==tail)
+   {/* Only drain the wake pipe when the ring is empty, then check again
+       because the reader could push in the middle. */
+    while (read(r->wake[0],b,sizeof(b))>0);
+    if (__atomic_load_n(&r->head,__ATOMIC_ACQUIRE)==tail)
+       return 0;
+   }
+ it=r->ring+(tail & (MI_READER_RING-1));
+ *o=it->o;
+ if (it->line)
+   {
+    free(h->line);
+    h->line=it->line;
+    h->llen=strlen(h->line)+1;
+    ret=1;
+   }
+ __atomic_store_n(&r->tail,tail+1,__ATOMIC_RELEASE);
+ return ret;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Checks if the reader thread stopped reading because gdb closed the pipe.
+Only reported after all the records already read are consumed.
+
+  Return: !=0 if nothing more will come from gdb.
+
+***************************************************************************/
+
+int mi_reader_eof(mi_h *h)
+{
+ mi_reader *r=h->reader;
+
+ return r && __atomic_load_n(&r->eof,__ATOMIC_ACQUIRE) &&
+        __atomic_load_n(&r->head,__ATOMIC_ACQUIRE)==r->tail;
+}
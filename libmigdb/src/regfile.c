@@ -0,0 +1,853 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Register file.
+  Comments:
+  An alternative to the mi_chg_reg lists. The registers are kept in arrays
+indexed by the register number. The names are stored in only one block and
+the values in an arena, so we don't need a malloc for each register. The
+responses from gdb are applied directly to the arrays, updating the
+changed registers costs O(changed).@p
+
+  The values are stored as text, in the format indicated at creation time.
+Use @x{mi_regfile_value} to get them.@p
+
+  For tools that read the registers at each step the values can also be
+decoded as binary, see @x{gmi_data_list_register_values_raw}. In this case
+the response isn't converted into a tree, the values are decoded directly
+from the line sent by gdb.@p
+
+  The register names only depend on the target architecture, so they are
+kept in a process wide cache keyed by a string that identifies the
+architecture (and the target description if needed). All the sessions
+share the tables, so only the first one asks gdb. The cache is protected
+by a mutex, so sessions running in different threads can use it.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include <pthread.h>
+#include "mi_gdb.h"
+
+#define MI_REGFILE_ARENA_MIN 1024
+
+/* From data_man.c */
+void mi_data_list_register_names(mi_h *h);
+void mi_data_list_changed_registers(mi_h *h);
+/* From connect.c */
+void mi_register_exit();
+
+/* Shared register names. */
+static mi_reg_names *reg_names_cache=NULL;
+static pthread_mutex_t reg_names_mutex=PTHREAD_MUTEX_INITIALIZER;
+
+/* Low level versions. */
+
+void mi_data_list_register_values_n(mi_h *h, enum mi_gvar_fmt fmt,
+                                    const int *regs, int count)
+{
+ char *b, *s;
+ int i;
+
+ if (!count)
+   {/* No list means all. */
+    mi_send(h,"-data-list-register-values %c\n",mi_format_enum_to_char(fmt));
+    return;
+   }
+ /* Send it in just one write. */
+ b=mi_malloc(count*12+40);
+ if (!b)
+    return;
+ s=b+sprintf(b,"-data-list-register-values %c",mi_format_enum_to_char(fmt));
+ for (i=0; i<count; i++)
+     s+=sprintf(s," %d",regs[i]);
+ strcpy(s,"\n");
+ mi_send(h,"%s",b);
+ free(b);
+}
+
+/* Arena handling. */
+
+static
+int mi_regfile_compact(mi_regfile *rf, int needed)
+{
+ int i, used=0, size=rf->arena_size;
+ char *na;
+
+ if (size<MI_REGFILE_ARENA_MIN)
+    size=MI_REGFILE_ARENA_MIN;
+ /* Grow if we are really using the space. */
+ while (rf->arena_used-rf->arena_waste+needed>size/2)
+    size*=2;
+ na=mi_malloc(size);
+ if (!na)
+    return 0;
+ for (i=0; i<rf->count; i++)
+    {
+     if (rf->val_off[i]<0)
+        continue;
+     memcpy(na+used,rf->arena+rf->val_off[i],rf->val_len[i]+1);
+     rf->val_off[i]=used;
+     used+=rf->val_len[i]+1;
+    }
+ free(rf->arena);
+ rf->arena=na;
+ rf->arena_size=size;
+ rf->arena_used=used;
+ rf->arena_waste=0;
+ return 1;
+}
+
+/* Stores a new value for register reg, returns 1 if it changed, 0 if not
+   and -1 on error. On error the old value is kept. */
+static
+int mi_regfile_set(mi_regfile *rf, int reg, const char *val)
+{
+ int len=strlen(val), off=rf->val_off[reg];
+
+ if (off>=0)
+   {
+    if (rf->val_len[reg]==len && memcmp(rf->arena+off,val,len)==0)
+       return 0;
+    if (len<=rf->val_len[reg])
+      {/* Reuse the space. */
+       memcpy(rf->arena+off,val,len+1);
+       rf->arena_waste+=rf->val_len[reg]-len;
+       rf->val_len[reg]=len;
+       return 1;
+      }
+   }
+ if (rf->arena_used+len+1>rf->arena_size &&
+     !mi_regfile_compact(rf,len+1))
+    return -1;
+ /* Now the old value, maybe moved by the compaction, is waste. */
+ if (rf->val_off[reg]>=0)
+    rf->arena_waste+=rf->val_len[reg]+1;
+ memcpy(rf->arena+rf->arena_used,val,len+1);
+ rf->val_off[reg]=rf->arena_used;
+ rf->val_len[reg]=len;
+ rf->arena_used+=len+1;
+ return 1;
+}
+
+/* Parsing of the responses. */
+
+static
+int mi_regfile_parse_names(mi_reg_names *rn, mi_results *r)
+{
+ mi_results *c;
+ int count=0, size=0;
+ char *s;
+
+ for (c=r; c; c=c->next)
+     if (c->type==t_const && !c->var)
+       {
+        count++;
+        size+=strlen(c->v.cstr)+1;
+       }
+ rn->names=(char **)mi_calloc(count ? count : 1,sizeof(char *));
+ rn->names_blk=s=mi_malloc(size ? size : 1);
+ if (!rn->names || !rn->names_blk)
+    return 0;
+ rn->count=0;
+ for (c=r; c; c=c->next)
+     if (c->type==t_const && !c->var)
+       {/* Unnamed registers are just holes, we keep them NULL. */
+        int l=strlen(c->v.cstr);
+        if (l)
+          {
+           memcpy(s,c->v.cstr,l+1);
+           rn->names[rn->count]=s;
+           s+=l+1;
+          }
+        rn->count++;
+       }
+ return 1;
+}
+
+/* Applies a register-values list. */
+static
+int mi_regfile_parse_values(mi_regfile *rf, mi_results *r)
+{
+ mi_results *c;
+ int reg;
+ const char *val;
+
+ for (; r; r=r->next)
+    {
+     if (r->type!=t_tuple || r->var)
+        continue;
+     reg=-1;
+     val=NULL;
+     for (c=r->v.rs; c; c=c->next)
+        {
+         if (c->type!=t_const || !c->var)
+            continue;
+         if (strcmp(c->var,"number")==0)
+            reg=atoi(c->v.cstr);
+         else if (strcmp(c->var,"value")==0)
+            val=c->v.cstr;
+        }
+     if (reg<0 || reg>=rf->count || !val)
+       {
+        mi_error=MI_PARSER;
+        return 0;
+       }
+     if (mi_regfile_set(rf,reg,val)<0)
+        return 0;
+    }
+ return 1;
+}
+
+static
+int mi_regfile_parse_changed(mi_regfile *rf, mi_results *r)
+{
+ int reg;
+
+ for (; r; r=r->next)
+    {
+     if (r->type!=t_const || r->var)
+        continue;
+     reg=atoi(r->v.cstr);
+     /* gdb bug mi/1770 could report registers we don't know. */
+     if (reg>=0 && reg<rf->count && rf->nchanged<rf->count)
+        rf->changed[rf->nchanged++]=reg;
+    }
+ return 1;
+}
+
+static
+int mi_regfile_res(mi_h *h, const char *var, void *p, int what)
+{
+ mi_results *r=mi_res_done_var(h,var);
+ mi_regfile *rf=(mi_regfile *)p;
+ int ok=0;
+
+ if (r && r->type==t_list)
+   {
+    switch (what)
+      {
+       case 0:
+            ok=mi_regfile_parse_names((mi_reg_names *)p,r->v.rs);
+            break;
+       case 1:
+            ok=mi_regfile_parse_values(rf,r->v.rs);
+            break;
+       case 2:
+            ok=mi_regfile_parse_changed(rf,r->v.rs);
+            break;
+      }
+   }
+ mi_free_results(r);
+ return ok;
+}
+
+/* Shared names. */
+
+static
+void mi_free_reg_names_st(mi_reg_names *rn)
+{
+ free(rn->key);
+ free(rn->names);
+ free(rn->names_blk);
+ free(rn);
+}
+
+/* Must be called with the mutex locked. */
+static
+mi_reg_names *mi_reg_names_find(const char *key)
+{
+ mi_reg_names *rn;
+
+ for (rn=reg_names_cache; rn; rn=rn->next)
+     if (strcmp(rn->key,key)==0)
+        return rn;
+ return NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Releases a reference to a names table obtained with
+@x{gmi_reg_names_get}. Tables in the cache are kept even when nobody uses
+them, call @x{mi_reg_names_flush} to release them.
+
+***************************************************************************/
+
+void mi_reg_names_release(mi_reg_names *rn)
+{
+ int dead;
+
+ if (!rn)
+    return;
+ pthread_mutex_lock(&reg_names_mutex);
+ dead=--rn->refs==0 && !rn->key;
+ pthread_mutex_unlock(&reg_names_mutex);
+ if (dead)
+    mi_free_reg_names_st(rn);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Releases the cached names tables that aren't in use. Called at exit.
+
+***************************************************************************/
+
+void mi_reg_names_flush()
+{
+ mi_reg_names *rn, **prev;
+
+ pthread_mutex_lock(&reg_names_mutex);
+ prev=&reg_names_cache;
+ while ((rn=*prev)!=NULL)
+   {
+    if (rn->refs)
+       prev=&rn->next;
+    else
+      {
+       *prev=rn->next;
+       mi_free_reg_names_st(rn);
+      }
+   }
+ pthread_mutex_unlock(&reg_names_mutex);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates a mi_chg_reg list from a names table, like
+@x{gmi_data_list_register_names} does, but without asking gdb. Unnamed
+registers get an empty name.
+
+  Return: A new list or NULL on error. @var{how_many} is filled with the
+number of elements.
+
+***************************************************************************/
+
+mi_chg_reg *mi_reg_names_to_chg_reg(mi_reg_names *rn, int *how_many)
+{
+ mi_chg_reg *first=NULL, *last=NULL, *c;
+ int i, n=0;
+
+ for (i=0; i<rn->count; i++)
+    {
+     c=mi_alloc_chg_reg();
+     if (!c || !(c->name=strdup(rn->names[i] ? rn->names[i] : "")))
+       {
+        free(c);
+        mi_error=MI_OUT_OF_MEMORY;
+        mi_free_chg_reg(first);
+        return NULL;
+       }
+     c->reg=i;
+     if (last)
+        last->next=c;
+     else
+        first=c;
+     last=c;
+     n++;
+    }
+ if (how_many)
+    *how_many=n;
+ return first;
+}
+
+/* Allocation. */
+
+static
+int mi_regfile_alloc_arrays(mi_regfile *rf)
+{
+ int n=rf->count ? rf->count : 1, i;
+
+ rf->val_off=(int *)mi_calloc(n,sizeof(int));
+ rf->val_len=(int *)mi_calloc(n,sizeof(int));
+ rf->changed=(int *)mi_calloc(n,sizeof(int));
+ rf->updated=(char *)mi_calloc(n,1);
+ if (!rf->val_off || !rf->val_len || !rf->changed || !rf->updated)
+    return 0;
+ for (i=0; i<rf->count; i++)
+     rf->val_off[i]=-1;
+ return 1;
+}
+
+void mi_free_regfile(mi_regfile *rf)
+{
+ if (!rf)
+    return;
+ mi_reg_names_release(rf->rnames);
+ free(rf->val_off);
+ free(rf->val_len);
+ free(rf->changed);
+ free(rf->updated);
+ free(rf->arena);
+ free(rf);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Returns the value of register @var{reg} as text. The pointer is valid
+until the next update.
+
+  Return: The value or NULL if unknown.
+
+***************************************************************************/
+
+const char *mi_regfile_value(mi_regfile *rf, int reg)
+{
+ if (reg<0 || reg>=rf->count || rf->val_off[reg]<0)
+    return NULL;
+ return rf->arena+rf->val_off[reg];
+}
+
+/* Raw values decoding. */
+
+static inline
+int mi_hex_digit(char c)
+{
+ if (c>='0' && c<='9')
+    return c-'0';
+ if (c>='a' && c<='f')
+    return c-'a'+10;
+ if (c>='A' && c<='F')
+    return c-'A'+10;
+ return -1;
+}
+
+/* Decodes a 0xNNNN number found at s into d. The number is big endian, we
+   store it in the target order. Returns the number of bytes or -1. */
+static
+int mi_raw_decode_hex(const char *s, const char **end, unsigned char *d,
+                      int max, int big_endian)
+{
+ const char *e;
+ int digits, bytes, i, hi;
+
+ if (s[0]!='0' || (s[1]!='x' && s[1]!='X'))
+    return -1;
+ s+=2;
+ for (e=s; mi_hex_digit(*e)>=0; e++);
+ *end=e;
+ digits=e-s;
+ bytes=(digits+1)/2;
+ if (!digits || bytes>max)
+    return -1;
+ /* Walk from the least significant byte. */
+ for (i=0, e--; i<bytes; i++, e-=2)
+    {
+     hi=e-1>=s ? mi_hex_digit(e[-1]) : 0;
+     d[big_endian ? bytes-1-i : i]=(hi<<4) | mi_hex_digit(*e);
+    }
+ return bytes;
+}
+
+/* Returns the end of the string starting at s, the closing quote. */
+static
+const char *mi_raw_str_end(const char *s)
+{
+ for (; *s && *s!='"'; s++)
+     if (*s=='\\' && s[1])
+        s++;
+ return s;
+}
+
+/* Looks for view in [s,e), only at the start of a member. */
+static
+const char *mi_raw_find_view(const char *s, const char *e, const char *view)
+{
+ int len=strlen(view);
+
+ for (s++; s+len<=e; s++)
+     if ((s[-1]=='{' || s[-1]==' ' || s[-1]=='_') &&
+         strncmp(s,view,len)==0)
+        return s+len;
+ return NULL;
+}
+
+/* Vector registers are reported as a tuple with all the possible views:
+   {v4_float = {...}, ..., v16_int8 = {0x1, 0x0 <repeats 15 times>}, ...}
+   The byte view is already in memory order, so we use it. The search is
+   limited to the value of this register, ending at e. */
+static
+const char *mi_raw_find_bytes(const char *s, const char *e)
+{
+ const char *p;
+
+ /* x86: vNN_int8 or vNN_uint8 */
+ if ((p=mi_raw_find_view(s,e,"int8 = {"))!=NULL ||
+     (p=mi_raw_find_view(s,e,"uint8 = {"))!=NULL)
+    return p;
+ /* ARM NEON: {u8 = {...}, u16 = ...} */
+ if ((p=mi_raw_find_view(s,e,"u8 = {"))!=NULL)
+    return p;
+ /* AArch64 and SVE: {d = {...}, ..., b = {u = {...}, s = {...}}, ...} */
+ return mi_raw_find_view(s,e,"b = {u = {");
+}
+
+/* Decodes the byte view, gdb compresses the runs of the same value, i.e.
+   {0x0 <repeats 16 times>} for a cleared register. Returns the number of
+   bytes or -1 if there is no byte view or it doesn't fit. */
+static
+int mi_raw_decode_vector(const char *s, unsigned char *d, int max)
+{
+ const char *e=mi_raw_str_end(s), *p=mi_raw_find_bytes(s,e), *n;
+ int c=0, rep;
+
+ if (!p)
+    return -1;
+ while (p<e && *p!='}')
+   {
+    if (c>=max || mi_raw_decode_hex(p,&n,d+c,1,0)!=1)
+       return -1;
+    c++;
+    for (p=n; *p==' '; p++);
+    if (strncmp(p,"<repeats ",9)==0)
+      {
+       rep=atoi(p+9);
+       if (rep<1 || rep-1>max-c)
+          return -1;
+       memset(d+c,d[c-1],rep-1);
+       c+=rep-1;
+       p=strchr(p,'>');
+       if (!p || p>=e)
+          return -1;
+       p++;
+      }
+    while (*p==',' || *p==' ')
+       p++;
+   }
+ return c;
+}
+
+/* Looks for the value of key in a {number="N",value="V"} tuple. Returns
+   a pointer to the first char of the value. */
+static
+const char *mi_raw_find(const char *s, const char *key, int len)
+{
+ for (; *s && *s!='}'; s++)
+    {
+     if (*s=='"')
+       {/* Skip strings, they could contain anything. */
+        for (s++; *s && *s!='"'; s++)
+            if (*s=='\\' && s[1])
+               s++;
+        if (!*s)
+           return NULL;
+       }
+     else if (strncmp(s,key,len)==0)
+        return s+len;
+    }
+ return NULL;
+}
+
+/* Skips a tuple, taking care of the strings. */
+static
+const char *mi_raw_skip_tuple(const char *s)
+{
+ for (; *s && *s!='}'; s++)
+     if (*s=='"')
+        for (s++; *s && *s!='"'; s++)
+            if (*s=='\\' && s[1])
+               s++;
+ return *s ? s+1 : s;
+}
+
+/* Also used by step_trace.c */
+int mi_raw_parse_values(const char *s, const int *regs, int count,
+                        unsigned char *buf, int stride, int *sizes,
+                        int big_endian)
+{
+ const char *v, *end;
+ int reg, slot, next=0, n=0, i;
+
+ s=strstr(s,"register-values=[");
+ if (!s)
+   {
+    mi_error=MI_PARSER;
+    return -1;
+   }
+ s+=17;
+ while (*s=='{')
+   {
+    v=mi_raw_find(s+1,"number=\"",8);
+    if (!v)
+      {
+       mi_error=MI_PARSER;
+       return -1;
+      }
+    reg=atoi(v);
+    /* Find the slot for this register, gdb keeps the order. */
+    slot=-1;
+    if (!regs)
+       slot=reg<count ? reg : -1;
+    else if (next<count && regs[next]==reg)
+       slot=next++;
+    else
+       for (i=0; i<count; i++)
+           if (regs[i]==reg)
+             {
+              slot=i;
+              break;
+             }
+    v=mi_raw_find(s+1,"value=\"",7);
+    if (slot>=0 && v)
+      {
+       unsigned char *d=buf+slot*stride;
+       if (*v=='{')
+          sizes[slot]=mi_raw_decode_vector(v,d,stride);
+       else
+          sizes[slot]=mi_raw_decode_hex(v,&end,d,stride,big_endian);
+       if (sizes[slot]>=0)
+          n++;
+      }
+    s=mi_raw_skip_tuple(s+1);
+    if (*s==',')
+       s++;
+   }
+ return n;
+}
+
+/* High level versions. */
+
+/**[txh]********************************************************************
+
+  Description:
+  Reads register values as binary. The values are requested in raw format
+and decoded directly into @var{buf}, without creating text values. Each
+register uses @var{stride} bytes of @var{buf} and the number of decoded
+bytes is stored in @var{sizes}, -1 if the value isn't available or doesn't
+fit. When @var{regs} is NULL all the registers are requested and @var{buf}
+and @var{sizes} are indexed by the register number, registers above
+@var{count} are ignored. Otherwise the @var{count} registers listed in
+@var{regs} are requested and the slots follow the order of @var{regs}.@p
+  Scalar registers are stored in the target byte order, indicated by
+@var{big_endian}. Vector registers are decoded from its byte view (x86
+vNN_int8, ARM u8 and AArch64/SVE b.u), so they are in memory order. Vectors
+without a byte view are reported as not available.
+
+  Command: -data-list-register-values r
+  Return: The number of decoded registers or -1 on error.
+
+***************************************************************************/
+
+int gmi_data_list_register_values_raw(mi_h *h, const int *regs, int count,
+                                      unsigned char *buf, int stride,
+                                      int *sizes, int big_endian)
+{
+ mi_output *r;
+ int i, n=-1;
+
+ for (i=0; i<count; i++)
+     sizes[i]=-1;
+ mi_error=MI_OK;
+ h->catch_result=1;
+ mi_data_list_register_values_n(h,fm_raw,regs,regs ? count : 0);
+ r=mi_get_response_blk(h);
+ if (!h->catch_result)
+    n=mi_raw_parse_values(h->catched_result,regs,count,buf,stride,sizes,
+                          big_endian);
+ else if (mi_error==MI_OK)
+    mi_error=MI_FROM_GDB;
+ h->catch_result=0;
+ mi_free_output(r);
+ return n;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the register names table for the current target. The @var{key}
+identifies the architecture, i.e. the name reported by "show architecture",
+plus anything that could change the registers (a target description file,
+a remote stub, etc.). If a table for @var{key} is in the cache no command
+is sent to gdb. Using NULL for @var{key} gets a private table, use it when
+the registers can't be identified, i.e. a remote stub that sends its own
+target description. Affected by
+gdb bug mi/1770.
+
+  Command: -data-list-register-names (only if not cached)
+  Return: The table or NULL on error. Release it using
+@x{mi_reg_names_release}.
+
+***************************************************************************/
+
+mi_reg_names *gmi_reg_names_get(mi_h *h, const char *key)
+{
+ mi_reg_names *rn, *old;
+
+ if (key)
+   {
+    pthread_mutex_lock(&reg_names_mutex);
+    rn=mi_reg_names_find(key);
+    if (rn)
+       rn->refs++;
+    pthread_mutex_unlock(&reg_names_mutex);
+    if (rn)
+       return rn;
+   }
+ /* Ask gdb without holding the lock. */
+ rn=(mi_reg_names *)mi_calloc1(sizeof(mi_reg_names));
+ if (!rn)
+    return NULL;
+ rn->refs=1;
+ mi_data_list_register_names(h);
+ if (!mi_regfile_res(h,"register-names",rn,0))
+   {
+    mi_free_reg_names_st(rn);
+    return NULL;
+   }
+ if (!key)
+    return rn;
+ rn->key=strdup(key);
+ if (!rn->key)
+   {
+    mi_error=MI_OUT_OF_MEMORY;
+    mi_free_reg_names_st(rn);
+    return NULL;
+   }
+ pthread_mutex_lock(&reg_names_mutex);
+ /* Another session could have added it meanwhile. */
+ old=mi_reg_names_find(key);
+ if (old)
+    old->refs++;
+ else
+   {
+    rn->next=reg_names_cache;
+    reg_names_cache=rn;
+    mi_register_exit();
+   }
+ pthread_mutex_unlock(&reg_names_mutex);
+ if (old)
+   {
+    mi_free_reg_names_st(rn);
+    rn=old;
+   }
+ return rn;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates a register file for the current target. The values will be
+requested using the @var{fmt} format. The values aren't filled, use
+@x{gmi_regfile_read_all}. The names are taken from the shared cache using
+@var{key}, see @x{gmi_reg_names_get}.
+
+  Command: -data-list-register-names (only if not cached)
+  Return: A new mi_regfile structure or NULL on error. Release it using
+mi_free_regfile.
+
+***************************************************************************/
+
+mi_regfile *gmi_regfile_create_key(mi_h *h, enum mi_gvar_fmt fmt,
+                                   const char *key)
+{
+ mi_regfile *rf=(mi_regfile *)mi_calloc1(sizeof(mi_regfile));
+
+ if (!rf)
+    return NULL;
+ rf->fmt=fmt;
+ rf->rnames=gmi_reg_names_get(h,key);
+ if (!rf->rnames)
+   {
+    mi_free_regfile(rf);
+    return NULL;
+   }
+ rf->count=rf->rnames->count;
+ rf->names=rf->rnames->names;
+ if (!mi_regfile_alloc_arrays(rf))
+   {
+    mi_free_regfile(rf);
+    return NULL;
+   }
+ return rf;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates a register file for the current target without using the names
+cache. See @x{gmi_regfile_create_key}.
+
+  Command: -data-list-register-names
+  Return: A new mi_regfile structure or NULL on error. Release it using
+mi_free_regfile.
+
+***************************************************************************/
+
+mi_regfile *gmi_regfile_create(mi_h *h, enum mi_gvar_fmt fmt)
+{
+ return gmi_regfile_create_key(h,fmt,NULL);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Reads the values of all the registers. The updated flags are cleared.
+
+  Command: -data-list-register-values
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_regfile_read_all(mi_h *h, mi_regfile *rf)
+{
+ memset(rf->updated,0,rf->count);
+ rf->nchanged=0;
+ mi_data_list_register_values_n(h,rf->fmt,NULL,0);
+ return mi_regfile_res(h,"register-values",rf,1);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Updates the values of the registers that changed since the last stop.
+Only the values of the changed registers are requested, the @var{changed}
+field contains their numbers and the @var{updated} array is !=0 for them.
+Note that gdb could report a register as changed even when its value is
+the same.
+
+  Command: -data-list-changed-registers + -data-list-register-values
+  Return: The number of changed registers or -1 on error.
+
+***************************************************************************/
+
+int gmi_regfile_update(mi_h *h, mi_regfile *rf)
+{
+ int i, n;
+
+ /* Clear only the flags we set, that's O(changed). */
+ for (i=0; i<rf->nchanged; i++)
+     rf->updated[rf->changed[i]]=0;
+ rf->nchanged=0;
+ mi_error=MI_OK;
+ mi_data_list_changed_registers(h);
+ if (!mi_regfile_res(h,"changed-registers",rf,2))
+    return -1;
+ n=rf->nchanged;
+ if (!n)
+    return 0;
+ for (i=0; i<n; i++)
+     rf->updated[rf->changed[i]]=1;
+ mi_data_list_register_values_n(h,rf->fmt,rf->changed,n);
+ if (!mi_regfile_res(h,"register-values",rf,1))
+    return -1;
+ return n;
+}
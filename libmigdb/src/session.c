@@ -0,0 +1,603 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Session state.
+  Comments:
+  A mi_session holds what the user configured in a debug session:
+breakpoints, watchpoints, display expressions and the source path. It can
+be saved to a file and restored in a fresh gdb, i.e. after running the
+target again or after gdb died. The restore sends everything in a
+pipeline (@x{mi_pipeline}).@p
+
+  The file is a text file, one item per line and the fields separated by
+tabs. Tabs, new lines and backslashes in the strings are escaped. An
+empty field is a NULL string:@p
+
+@<pre>
+MISESSION 1
+D path
+B mode disp type enabled ignore thread line addr file func cond
+W mode enabled exp
+E exp
+@</pre>
+
+***************************************************************************/
+
+#include <string.h>
+#include "mi_gdb.h"
+
+#define MI_SES_MAGIC "MISESSION 1"
+
+/* From bkpt_tab.c */
+void mi_bkpt_insert_req(mi_h *h, mi_bkpt *r);
+int mi_bkpt_tab_res_req(mi_h *h, mi_bkpt_tab *t, mi_bkpt *r);
+/* From breakpoint.c */
+void mi_break_watch(mi_h *h, enum mi_wp_mode mode, const char *exp);
+/* From data_man.c */
+void mi_dir(mi_h *h, const char *path);
+/* From var_obj.c */
+void mi_var_create(mi_h *h, const char *name, int frame, const char *exp);
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates an empty session.
+
+  Return: A new session or NULL on error. Release it using
+@x{mi_free_session}.
+
+***************************************************************************/
+
+mi_session *mi_new_session()
+{
+ return (mi_session *)mi_calloc1(sizeof(mi_session));
+}
+
+void mi_free_session(mi_session *s)
+{
+ int i;
+
+ if (!s)
+    return;
+ free(s->path);
+ mi_free_bkpt(s->bkpts);
+ mi_free_wp(s->wps);
+ for (i=0; i<s->nexps; i++)
+     free(s->exps[i]);
+ free(s->exps);
+ free(s);
+}
+
+/* Copies s to *d, NULL and empty strings are NULL. */
+static
+int mi_ses_dup(char **d, const char *s)
+{
+ free(*d);
+ *d=NULL;
+ if (!s || !*s)
+    return 1;
+ *d=strdup(s);
+ if (*d)
+    return 1;
+ mi_error=MI_OUT_OF_MEMORY;
+ return 0;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Sets the source path, see @x{gmi_dir}.
+
+  Return: !=0 OK
+
+***************************************************************************/
+
+int mi_session_set_path(mi_session *s, const char *path)
+{
+ return mi_ses_dup(&s->path,path);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Adds a copy of the breakpoint @var{b}. The location is taken from the
+mode field, if it's m_file_line and the breakpoint doesn't have a file the
+function or the address is used.
+
+  Return: The copy, owned by the session, or NULL on error.
+
+***************************************************************************/
+
+mi_bkpt *mi_session_add_bkpt(mi_session *s, mi_bkpt *b)
+{
+ mi_bkpt *c=mi_alloc_bkpt();
+
+ if (!c)
+    return NULL;
+ c->type=b->type;
+ c->disp=b->disp;
+ c->enabled=b->enabled;
+ c->addr=b->addr;
+ c->line=b->line;
+ c->ignore=b->ignore;
+ c->thread=b->thread;
+ c->mode=b->mode;
+ if (!mi_ses_dup(&c->file,b->file) || !mi_ses_dup(&c->func,b->func) ||
+     !mi_ses_dup(&c->cond,b->cond))
+   {
+    mi_free_bkpt(c);
+    return NULL;
+   }
+ if (c->mode==m_file_line && !c->file)
+    c->mode=c->func ? m_function : m_address;
+ if (s->last_bkpt)
+    s->last_bkpt->next=c;
+ else
+    s->bkpts=c;
+ s->last_bkpt=c;
+ return c;
+}
+
+static
+int mi_ses_cmp_num(const void *a, const void *b)
+{
+ return (*(mi_bkpt **)a)->number-(*(mi_bkpt **)b)->number;
+}
+
+/* Only plain breakpoints can be restored using -break-insert. The
+   dprintf, tracepoint and watchpoint entries of a table don't keep the
+   information needed to create them again. */
+static
+int mi_ses_can_insert(mi_bkpt *b)
+{
+ return b->type==t_unknown || b->type==t_breakpoint || b->type==t_hw;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Adds a copy of all the breakpoints in the table @var{t}, sorted by
+number, so they are created in the same order. Only the breakpoints,
+hardware breakpoints and entries of unknown type are copied, the dprintf,
+tracepoint and watchpoint entries are skipped.
+
+  Return: !=0 OK
+
+***************************************************************************/
+
+int mi_session_add_bkpt_tab(mi_session *s, mi_bkpt_tab *t)
+{
+ mi_bkpt **a, *b;
+ int i, n=0, ok=1;
+
+ if (!t->count)
+    return 1;
+ a=(mi_bkpt **)mi_malloc(t->count*sizeof(mi_bkpt *));
+ if (!a)
+    return 0;
+ for (b=t->list; b && n<t->count; b=b->next)
+     if (mi_ses_can_insert(b))
+        a[n++]=b;
+ qsort(a,n,sizeof(mi_bkpt *),mi_ses_cmp_num);
+ for (i=0; ok && i<n; i++)
+     ok=mi_session_add_bkpt(s,a[i])!=NULL;
+ free(a);
+ return ok;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Adds a watchpoint for the expression @var{exp}.
+
+  Return: The new watchpoint, owned by the session, or NULL on error.
+
+***************************************************************************/
+
+mi_wp *mi_session_add_wp(mi_session *s, enum mi_wp_mode mode,
+                         const char *exp, int enabled)
+{
+ mi_wp *w=mi_alloc_wp();
+
+ if (!w)
+    return NULL;
+ if (!mi_ses_dup(&w->exp,exp) || !w->exp)
+   {
+    mi_free_wp(w);
+    return NULL;
+   }
+ w->mode=mode;
+ w->enabled=enabled;
+ if (s->last_wp)
+    s->last_wp->next=w;
+ else
+    s->wps=w;
+ s->last_wp=w;
+ return w;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Adds a display expression, restored as a variable object.
+
+  Return: !=0 OK
+
+***************************************************************************/
+
+int mi_session_add_exp(mi_session *s, const char *exp)
+{
+ if (s->nexps>=s->aexps)
+   {
+    int n=s->aexps ? s->aexps*2 : 16;
+    char **e=(char **)realloc(s->exps,n*sizeof(char *));
+    if (!e)
+      {
+       mi_error=MI_OUT_OF_MEMORY;
+       return 0;
+      }
+    s->exps=e;
+    s->aexps=n;
+   }
+ s->exps[s->nexps]=NULL;
+ if (!mi_ses_dup(s->exps+s->nexps,exp) || !s->exps[s->nexps])
+    return 0;
+ s->nexps++;
+ return 1;
+}
+
+/* Writes a tab and the escaped string. */
+static
+void mi_ses_put(FILE *f, const char *s)
+{
+ fputc('\t',f);
+ if (!s)
+    return;
+ for (; *s; s++)
+     switch (*s)
+       {
+        case '\t':
+             fputs("\\t",f);
+             break;
+        case '\n':
+             fputs("\\n",f);
+             break;
+        case '\\':
+             fputs("\\\\",f);
+             break;
+        default:
+             fputc(*s,f);
+       }
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Writes the session to @var{f}. See the module comments for the format.
+
+  Return: !=0 OK
+
+***************************************************************************/
+
+int mi_session_save(mi_session *s, FILE *f)
+{
+ mi_bkpt *b;
+ mi_wp *w;
+ int i;
+
+ fputs(MI_SES_MAGIC "\n",f);
+ if (s->path)
+   {
+    fputc('D',f);
+    mi_ses_put(f,s->path);
+    fputc('\n',f);
+   }
+ for (b=s->bkpts; b; b=b->next)
+    {
+     fprintf(f,"B\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%lx",b->mode,b->disp,b->type,
+             b->enabled,b->ignore,b->thread,b->line,(unsigned long)b->addr);
+     mi_ses_put(f,b->file);
+     mi_ses_put(f,b->func);
+     mi_ses_put(f,b->cond);
+     fputc('\n',f);
+    }
+ for (w=s->wps; w; w=w->next)
+    {
+     fprintf(f,"W\t%d\t%d",w->mode,w->enabled);
+     mi_ses_put(f,w->exp);
+     fputc('\n',f);
+    }
+ for (i=0; i<s->nexps; i++)
+    {
+     fputc('E',f);
+     mi_ses_put(f,s->exps[i]);
+     fputc('\n',f);
+    }
+ return !ferror(f);
+}
+
+/* Splits the line in tab separated fields and unescapes them, in place. */
+static
+int mi_ses_split(char *l, char **fields, int max)
+{
+ int n=0;
+ char *d;
+
+ while (n<max)
+   {
+    fields[n++]=d=l;
+    for (; *l && *l!='\t' && *l!='\n'; l++)
+       {
+        if (*l=='\\' && l[1])
+          {
+           l++;
+           *(d++)=*l=='t' ? '\t' : *l=='n' ? '\n' : *l;
+          }
+        else
+           *(d++)=*l;
+       }
+    if (*l!='\t')
+      {
+       *d=0;
+       break;
+      }
+    l++;
+    *d=0;
+   }
+ return n;
+}
+
+static
+int mi_ses_load_line(mi_session *s, char *l)
+{
+ char *f[12];
+ int n=mi_ses_split(l,f,12);
+ mi_bkpt b;
+ mi_wp *w;
+
+ switch (*f[0])
+   {
+    case 'D':
+         return n==2 && mi_session_set_path(s,f[1]);
+    case 'B':
+         if (n!=12)
+            return 0;
+         memset(&b,0,sizeof(b));
+         b.mode=atoi(f[1]);
+         b.disp=atoi(f[2]);
+         b.type=atoi(f[3]);
+         b.enabled=atoi(f[4]);
+         b.ignore=atoi(f[5]);
+         b.thread=atoi(f[6]);
+         b.line=atoi(f[7]);
+         b.addr=(void *)strtoul(f[8],NULL,16);
+         b.file=f[9];
+         b.func=f[10];
+         b.cond=f[11];
+         return mi_session_add_bkpt(s,&b)!=NULL;
+    case 'W':
+         if (n!=4)
+            return 0;
+         w=mi_session_add_wp(s,atoi(f[1]),f[3],atoi(f[2]));
+         return w!=NULL;
+    case 'E':
+         return n==2 && mi_session_add_exp(s,f[1]);
+   }
+ /* Unknown items are skipped, they could come from a newer version. */
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Reads a session written by @x{mi_session_save}.
+
+  Return: A new session or NULL on error. Release it using
+@x{mi_free_session}.
+
+***************************************************************************/
+
+mi_session *mi_session_load(FILE *f)
+{
+ mi_session *s;
+ char *l=NULL;
+ size_t size=0;
+
+ if (getline(&l,&size,f)<0 || strncmp(l,MI_SES_MAGIC,strlen(MI_SES_MAGIC)))
+   {
+    free(l);
+    mi_error=MI_PARSER;
+    return NULL;
+   }
+ s=mi_new_session();
+ while (s && getline(&l,&size,f)>=0)
+    {
+     mi_error=MI_PARSER;
+     if (*l && *l!='\n' && !mi_ses_load_line(s,l))
+       {
+        mi_free_session(s);
+        s=NULL;
+       }
+    }
+ free(l);
+ if (s)
+    mi_error=MI_OK;
+ return s;
+}
+
+/* Restore. */
+typedef struct
+{
+ mi_session *s;
+ mi_bkpt_tab *t;
+ mi_var_reg *r;
+ char *kind;
+ void **items;
+} mi_ses_batch;
+
+static
+void mi_ses_send(mi_h *h, int i, void *data)
+{
+ mi_ses_batch *b=(mi_ses_batch *)data;
+ mi_wp *w;
+ mi_bkpt bk;
+
+ switch (b->kind[i])
+   {
+    case 'D':
+         mi_dir(h,b->s->path);
+         break;
+    case 'B':
+         /* The old thread numbers are meaningless for this gdb. */
+         bk=*(mi_bkpt *)b->items[i];
+         bk.thread=0;
+         mi_bkpt_insert_req(h,&bk);
+         break;
+    case 'W':
+         w=(mi_wp *)b->items[i];
+         mi_break_watch(h,w->mode,w->exp);
+         break;
+    case 'E':
+         mi_var_create(h,NULL,-1,(char *)b->items[i]);
+         break;
+   }
+}
+
+static
+int mi_ses_recv(mi_h *h, int i, void *data)
+{
+ mi_ses_batch *b=(mi_ses_batch *)data;
+ mi_wp *w, *res;
+ mi_gvar *v;
+
+ switch (b->kind[i])
+   {
+    case 'D':
+         return mi_res_simple_done(h);
+    case 'B':
+         return mi_bkpt_tab_res_req(h,b->t,(mi_bkpt *)b->items[i]);
+    case 'W':
+         w=(mi_wp *)b->items[i];
+         res=mi_res_wp(h);
+         w->number=res ? res->number : 0;
+         mi_free_wp(res);
+         return w->number!=0;
+    case 'E':
+         v=mi_res_gvar(h,NULL,(char *)b->items[i]);
+         if (!v)
+            return 0;
+         mi_var_reg_add(b->r,v);
+         return 1;
+   }
+ return 0;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Restores the session @var{s} in a fresh gdb. The source path, the
+breakpoints, the watchpoints and the display expressions are sent in one
+pipeline. The breakpoints are added to @var{t} and the expressions are
+created as variable objects in @var{r}, if @var{r} is NULL the expressions
+are skipped. The number fields of the session breakpoints and watchpoints
+are set to the new numbers, 0 if the item failed or can't be restored
+(dprintf, tracepoint and watchpoint entries). Then the disabled items
+are disabled, also using a pipeline.@p
+  The thread restrictions are dropped, the thread numbers of the old
+gdb don't exist in the new one and the breakpoint would be rejected. The
+thread field of the session breakpoints is kept.@p
+  The watchpoints usually need a running target.
+
+  Command: -environment-directory + -break-insert + -break-watch +
+-var-create + -break-disable
+  Return: The number of items restored or -1 if gdb died.
+
+***************************************************************************/
+
+int gmi_session_restore(mi_h *h, mi_session *s, mi_bkpt_tab *t,
+                        mi_var_reg *r)
+{
+ mi_ses_batch b;
+ mi_bkpt *bk;
+ mi_wp *w;
+ int n=0, i, ret, *dis, ndis=0;
+
+ /* Count the items. */
+ if (s->path)
+    n++;
+ for (bk=s->bkpts; bk; bk=bk->next)
+     n++;
+ for (w=s->wps; w; w=w->next)
+     n++;
+ if (r)
+    n+=s->nexps;
+ if (!n)
+    return 0;
+ b.s=s;
+ b.t=t;
+ b.r=r;
+ b.kind=(char *)mi_malloc(n);
+ b.items=(void **)mi_malloc(n*sizeof(void *));
+ dis=(int *)mi_malloc(n*sizeof(int));
+ if (!b.kind || !b.items || !dis)
+   {
+    free(b.kind);
+    free(b.items);
+    free(dis);
+    return -1;
+   }
+ n=0;
+ if (s->path)
+    b.kind[n++]='D';
+ for (bk=s->bkpts; bk; bk=bk->next)
+    {
+     bk->number=0;
+     if (mi_ses_can_insert(bk))
+       {
+        b.kind[n]='B';
+        b.items[n++]=bk;
+       }
+    }
+ for (w=s->wps; w; w=w->next, n++)
+    {
+     b.kind[n]='W';
+     b.items[n]=w;
+    }
+ for (i=0; r && i<s->nexps; i++, n++)
+    {
+     b.kind[n]='E';
+     b.items[n]=s->exps[i];
+    }
+ ret=mi_pipeline(h,n,mi_ses_send,mi_ses_recv,&b);
+ if (ret>=0)
+   {/* Disable the ones that were disabled. */
+    for (bk=s->bkpts; bk; bk=bk->next)
+        if (bk->number && !bk->enabled)
+           dis[ndis++]=bk->number;
+    for (w=s->wps; w; w=w->next)
+        if (w->number && !w->enabled)
+           dis[ndis++]=w->number;
+    if (ndis && gmi_bkpt_tab_enable(h,t,dis,ndis,0)<0)
+       ret=-1;
+   }
+ free(b.kind);
+ free(b.items);
+ free(dis);
+ return ret;
+}
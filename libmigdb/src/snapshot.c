@@ -0,0 +1,263 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Stop snapshot.
+  Comments:
+  After each stop a front-end usually wants to know the current frame, its
+arguments and locals, the registers and the threads. Asking one by one
+costs a round trip for each. Here all the commands are sent in a pipeline
+(@x{mi_pipeline}) and the answers are collected in a mi_snapshot.@p
+
+  The snapshot is a copy, it doesn't change when the target moves. The
+stop_gen field can be compared with @x{mi_get_stop_gen} to know if it's
+still current.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include "mi_gdb.h"
+
+/* From stack_man.c */
+void mi_stack_info_frame_mi(mi_h *h);
+void mi_stack_list_variables(mi_h *h, int show);
+/* From parse.c */
+mi_results *mi_get_var_r(mi_results *r, const char *var);
+/* From data_man.c */
+void mi_data_list_changed_registers(mi_h *h);
+void mi_data_list_register_values(mi_h *h, enum mi_gvar_fmt fmt, mi_chg_reg *l);
+/* From thread.c */
+void mi_thread_list_ids(mi_h *h);
+
+/* The arguments and locals of the selected frame are obtained using only
+   one command, so they can't come from different frames. */
+#define MI_SNAP_VARS (MI_SNAP_ARGS | MI_SNAP_LOCALS)
+
+/* Parts in the order we send them. */
+static const unsigned mi_snap_parts[]=
+{
+ MI_SNAP_FRAME, MI_SNAP_VARS, MI_SNAP_CHANGED, MI_SNAP_REGS, MI_SNAP_THREADS
+};
+#define MI_SNAP_NPARTS (sizeof(mi_snap_parts)/sizeof(unsigned))
+
+typedef struct
+{
+ mi_snapshot *s;
+ unsigned parts[MI_SNAP_NPARTS];
+ enum mi_gvar_fmt fmt;
+} mi_snap_batch;
+
+static
+void mi_snap_send(mi_h *h, int i, void *data)
+{
+ mi_snap_batch *b=(mi_snap_batch *)data;
+
+ switch (b->parts[i])
+   {
+    case MI_SNAP_FRAME:
+         mi_stack_info_frame_mi(h);
+         break;
+    case MI_SNAP_ARGS:
+    case MI_SNAP_LOCALS:
+    case MI_SNAP_VARS:
+         mi_stack_list_variables(h,1);
+         break;
+    case MI_SNAP_CHANGED:
+         mi_data_list_changed_registers(h);
+         break;
+    case MI_SNAP_REGS:
+         mi_data_list_register_values(h,b->fmt,NULL);
+         break;
+    case MI_SNAP_THREADS:
+         mi_thread_list_ids(h);
+         break;
+   }
+}
+
+/* Splits the variables=[...] list from -stack-list-variables, the
+   arguments have arg="1". The arguments are moved to args and the node is
+   kept as locals=[...], the same we get from -stack-list-locals. */
+static
+void mi_snap_split_vars(mi_snapshot *s, mi_results *vars, unsigned parts)
+{
+ mi_results *v, *next, **args=&s->args, **locals, *a;
+
+ v=vars->v.rs;
+ vars->v.rs=NULL;
+ locals=&vars->v.rs;
+ for (; v; v=next)
+    {
+     next=v->next;
+     v->next=NULL;
+     a=v->type==t_tuple ? mi_get_var_r(v->v.rs,"arg") : NULL;
+     if (a && a->type==t_const && strcmp(a->v.cstr,"1")==0)
+       {
+        *args=v;
+        args=&v->next;
+       }
+     else
+       {
+        *locals=v;
+        locals=&v->next;
+       }
+    }
+ if (!(parts & MI_SNAP_ARGS))
+   {
+    mi_free_results(s->args);
+    s->args=NULL;
+   }
+ if (parts & MI_SNAP_LOCALS)
+   {/* Shorter than "variables", fits in place. */
+    strcpy(vars->var,"locals");
+    s->locals=vars;
+   }
+ else
+    mi_free_results(vars);
+}
+
+static
+int mi_snap_recv(mi_h *h, int i, void *data)
+{
+ mi_snap_batch *b=(mi_snap_batch *)data;
+ mi_snapshot *s=b->s;
+ mi_results *v;
+ mi_chg_reg *c;
+
+ switch (b->parts[i])
+   {
+    case MI_SNAP_FRAME:
+         s->frame=mi_res_frame(h);
+         if (!s->frame)
+            return 0;
+         break;
+    case MI_SNAP_ARGS:
+    case MI_SNAP_LOCALS:
+    case MI_SNAP_VARS:
+         mi_error=MI_OK;
+         v=mi_res_done_var(h,"variables");
+         /* No variables is valid. */
+         if (!v && mi_error!=MI_OK)
+            return 0;
+         if (v && v->type==t_list && v->var)
+            mi_snap_split_vars(s,v,b->parts[i]);
+         else
+            mi_free_results(v);
+         break;
+    case MI_SNAP_CHANGED:
+         mi_error=MI_OK;
+         s->changed=mi_get_list_changed_regs(h);
+         if (!s->changed && mi_error!=MI_OK)
+            return 0;
+         for (c=s->changed; c; c=c->next)
+             s->nchanged++;
+         break;
+    case MI_SNAP_REGS:
+         s->regs=mi_get_reg_values_l(h,&s->nregs);
+         if (!s->regs)
+            return 0;
+         break;
+    case MI_SNAP_THREADS:
+         s->nthreads=mi_res_thread_ids(h,&s->threads);
+         if (s->nthreads<0)
+           {
+            s->nthreads=0;
+            return 0;
+           }
+         break;
+   }
+ s->have|=b->parts[i];
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Takes a snapshot of the stopped target. The @var{what} mask indicates
+which parts are requested (MI_SNAP_* values, MI_SNAP_ALL for all). All the
+commands are sent in a pipeline. The register values are requested using
+the @var{fmt} format and the ones that changed since the last stop have
+the updated field set. The have field indicates which parts were obtained,
+a part can fail without affecting the others.
+
+  Command: -stack-info-frame + -stack-list-variables +
+-data-list-changed-registers + -data-list-register-values +
+-thread-list-ids
+  Return: A new mi_snapshot or NULL on error. Release it using
+@x{mi_free_snapshot}.
+
+***************************************************************************/
+
+mi_snapshot *gmi_snapshot(mi_h *h, unsigned what, enum mi_gvar_fmt fmt)
+{
+ mi_snap_batch b;
+ mi_snapshot *s;
+ mi_chg_reg *r, *c;
+ int i, n=0, max=-1;
+
+ s=(mi_snapshot *)mi_calloc1(sizeof(mi_snapshot));
+ if (!s)
+    return NULL;
+ s->stop_gen=mi_get_stop_gen(h);
+ b.s=s;
+ b.fmt=fmt;
+ for (i=0; i<(int)MI_SNAP_NPARTS; i++)
+     if (what & mi_snap_parts[i])
+        b.parts[n++]=what & mi_snap_parts[i];
+ if (mi_pipeline(h,n,mi_snap_send,mi_snap_recv,&b)<0)
+   {
+    mi_free_snapshot(s);
+    return NULL;
+   }
+ /* Mark the registers that changed. */
+ for (c=s->changed; c; c=c->next)
+     if (c->reg>max)
+        max=c->reg;
+ if (max>=0)
+   {
+    char *chg=(char *)mi_calloc(max+1,1);
+    if (chg)
+      {
+       for (c=s->changed; c; c=c->next)
+           if (c->reg>=0)
+              chg[c->reg]=1;
+       for (r=s->regs; r; r=r->next)
+           r->updated=r->reg>=0 && r->reg<=max && chg[r->reg];
+       free(chg);
+      }
+   }
+ /* The arguments for the current frame. */
+ if (s->frame && !s->frame->args)
+   {
+    s->frame->args=s->args;
+    s->args=NULL;
+   }
+ return s;
+}
+
+void mi_free_snapshot(mi_snapshot *s)
+{
+ if (!s)
+    return;
+ mi_free_frames(s->frame);
+ mi_free_results(s->args);
+ mi_free_results(s->locals);
+ mi_free_chg_reg(s->changed);
+ mi_free_chg_reg(s->regs);
+ free(s->threads);
+ free(s);
+}
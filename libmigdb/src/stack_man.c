@@ -32,8 +32,13 @@ gdb command:              Implemented?
 -stack-select-frame       Yes
 @</pre>
 
+  The mi_backtrace object is a lazy alternative to
+@x{gmi_stack_list_frames}. The frames are requested in pages, only when
+needed, and are kept until the target resumes.@p
+
 ***************************************************************************/
 
+#include <string.h>
 #include "mi_gdb.h"
 
 /* Low level versions. */
@@ -46,6 +51,15 @@ void mi_stack_list_frames(mi_h *h, int from, int to)
     mi_send(h,"-stack-list-frames %d %d\n",from,to);
 }
 
+/* For a particular thread, needs gdb 7.0 or newer. */
+void mi_stack_list_frames_t(mi_h *h, int thread, int from, int to)
+{
+ if (from<0)
+    mi_send(h,"-stack-list-frames --thread %d\n",thread);
+ else
+    mi_send(h,"-stack-list-frames --thread %d %d %d\n",thread,from,to);
+}
+
 void mi_stack_list_arguments(mi_h *h, int show, int from, int to)
 {
  if (from<0)
@@ -59,6 +73,12 @@ void mi_stack_info_frame(mi_h *h)
  mi_send(h,"frame\n");
 }
 
+/* The real MI command, gdb 6.x or newer. */
+void mi_stack_info_frame_mi(mi_h *h)
+{
+ mi_send(h,"-stack-info-frame\n");
+}
+
 void mi_stack_info_depth(mi_h *h, int depth)
 {
  if (depth<0)
@@ -77,6 +97,11 @@ void mi_stack_list_locals(mi_h *h, int show)
  mi_send(h,"-stack-list-locals %d\n",show);
 }
 
+void mi_stack_list_variables(mi_h *h, int show)
+{
+ mi_send(h,"-stack-list-variables %d\n",show);
+}
+
 /* High level versions. */
 
 /**[txh]********************************************************************
@@ -214,6 +239,7 @@ int gmi_stack_info_depth_get(mi_h *h)
 
 int gmi_stack_select_frame(mi_h *h, int framenum)
 {
+ mi_selection_changed(h,0);
  mi_stack_select_frame(h,framenum);
  return mi_res_simple_done(h);
 }
@@ -234,3 +260,273 @@ mi_results *gmi_stack_list_locals(mi_h *h, int show)
  return mi_res_done_var(h,"locals");
 }
 
+
+/* Paged backtrace. */
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates a backtrace object. The frames will be requested in groups of
+@var{page} frames and never past @var{max_depth}. If @var{args} is >=0 the
+arguments are also requested, using it as the "show" value for
+-stack-list-arguments. No command is sent to gdb.
+
+  Return: A new mi_backtrace or NULL on error. Release it using
+@x{mi_free_backtrace}.
+
+***************************************************************************/
+
+mi_backtrace *mi_new_backtrace(int page, int max_depth, int args)
+{
+ mi_backtrace *bt=(mi_backtrace *)mi_calloc1(sizeof(mi_backtrace));
+
+ if (!bt)
+    return NULL;
+ bt->page=page>0 ? page : MI_DEFAULT_BT_PAGE;
+ bt->max_depth=max_depth>0 ? max_depth : MI_DEFAULT_BT_MAX_DEPTH;
+ bt->args=args;
+ bt->depth=-1;
+ return bt;
+}
+
+/* Discards all the frames. */
+static
+void mi_backtrace_clear(mi_backtrace *bt)
+{
+ int i;
+
+ for (i=0; i<bt->size; i++)
+    {
+     mi_free_frames(bt->frames[i]);
+     bt->frames[i]=NULL;
+    }
+ if (bt->size)
+    memset(bt->pages,0,(bt->size+bt->page-1)/bt->page);
+ bt->depth=-1;
+ bt->truncated=0;
+}
+
+void mi_free_backtrace(mi_backtrace *bt)
+{
+ if (!bt)
+    return;
+ mi_backtrace_clear(bt);
+ free(bt->frames);
+ free(bt->pages);
+ free(bt);
+}
+
+/* The frames are valid only for the stop and thread where we got them. */
+static
+void mi_backtrace_check(mi_h *h, mi_backtrace *bt)
+{
+ if (bt->stop_gen!=mi_get_stop_gen(h) || bt->thread_gen!=h->thread_gen)
+   {
+    mi_backtrace_clear(bt);
+    bt->stop_gen=mi_get_stop_gen(h);
+    bt->thread_gen=h->thread_gen;
+   }
+}
+
+/* Makes room for levels 0 to levels-1, rounded to pages. */
+static
+int mi_backtrace_reserve(mi_backtrace *bt, int levels)
+{
+ int npages, opages, size;
+ mi_frames **f;
+ char *p;
+
+ if (levels<=bt->size)
+    return 1;
+ npages=(levels+bt->page-1)/bt->page;
+ opages=(bt->size+bt->page-1)/bt->page;
+ size=npages*bt->page;
+ f=(mi_frames **)realloc(bt->frames,size*sizeof(mi_frames *));
+ if (f)
+    bt->frames=f;
+ p=(char *)realloc(bt->pages,npages);
+ if (p)
+    bt->pages=p;
+ if (!f || !p)
+   {
+    mi_error=MI_OUT_OF_MEMORY;
+    return 0;
+   }
+ memset(bt->frames+bt->size,0,(size-bt->size)*sizeof(mi_frames *));
+ memset(bt->pages+opages,0,npages-opages);
+ bt->size=size;
+ return 1;
+}
+
+typedef struct
+{
+ mi_backtrace *bt;
+ int *pages;
+ int cmds; /* Commands for each page. */
+} mi_bt_batch;
+
+static
+void mi_bt_batch_send(mi_h *h, int i, void *data)
+{
+ mi_bt_batch *b=(mi_bt_batch *)data;
+ mi_backtrace *bt=b->bt;
+ int from=b->pages[i/b->cmds]*bt->page;
+ int to=from+bt->page-1;
+
+ if (to>=bt->max_depth)
+    to=bt->max_depth-1;
+ if (i%b->cmds)
+    mi_stack_list_arguments(h,bt->args,from,to);
+ else
+    mi_stack_list_frames(h,from,to);
+}
+
+static
+int mi_bt_batch_recv(mi_h *h, int i, void *data)
+{
+ mi_bt_batch *b=(mi_bt_batch *)data;
+ mi_backtrace *bt=b->bt;
+ int page=b->pages[i/b->cmds];
+ int from=page*bt->page, n=0;
+ mi_frames *l, *f;
+
+ if (i%b->cmds)
+   {/* Arguments, move them to the frames we got. */
+    l=mi_res_frames_array(h,"stack-args");
+    if (!l)
+       return 0;
+    for (f=l; f; f=f->next)
+        if (f->level>=from && f->level<bt->size && bt->frames[f->level])
+          {
+           bt->frames[f->level]->args=f->args;
+           f->args=NULL;
+          }
+    mi_free_frames(l);
+    return 1;
+   }
+ mi_error=MI_OK;
+ l=mi_res_frames_array(h,"stack");
+ /* gdb reports an error if we ask for frames past the end. */
+ if (!l && mi_error!=MI_OK && mi_error!=MI_FROM_GDB)
+    return 0;
+ bt->pages[page]=1;
+ while (l)
+   {
+    f=l;
+    l=l->next;
+    f->next=NULL;
+    if (f->level>=from && f->level<bt->size && !bt->frames[f->level])
+      {
+       bt->frames[f->level]=f;
+       n++;
+      }
+    else
+       mi_free_frames(f);
+   }
+ /* A short page is the end of the stack. */
+ if (n<bt->page && from+n<bt->max_depth &&
+     (bt->depth<0 || from+n<bt->depth))
+    bt->depth=from+n;
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Makes sure the frames in the @var{from} - @var{to} range are available.
+Only the missing pages are requested, the frames and arguments for all of
+them are sent in a pipeline (@x{mi_pipeline}). The frames are discarded
+when the target resumes.
+
+  Command: -stack-list-frames + -stack-list-arguments
+  Return: The number of frames available in the range or -1 on error.
+
+***************************************************************************/
+
+int gmi_backtrace_fetch(mi_h *h, mi_backtrace *bt, int from, int to)
+{
+ mi_bt_batch b;
+ int first, last, i, n=0, np=0;
+
+ mi_backtrace_check(h,bt);
+ if (from<0)
+    from=0;
+ if (to>=bt->max_depth)
+    to=bt->max_depth-1;
+ if (bt->depth>=0 && to>=bt->depth)
+    to=bt->depth-1;
+ if (to<from)
+    return 0;
+ if (!mi_backtrace_reserve(bt,to+1))
+    return -1;
+ first=from/bt->page;
+ last=to/bt->page;
+ b.bt=bt;
+ b.cmds=bt->args>=0 ? 2 : 1;
+ b.pages=(int *)mi_calloc(last-first+1,sizeof(int));
+ if (!b.pages)
+    return -1;
+ for (i=first; i<=last; i++)
+     if (!bt->pages[i])
+        b.pages[np++]=i;
+ if (np && mi_pipeline(h,np*b.cmds,mi_bt_batch_send,mi_bt_batch_recv,&b)<0)
+   {
+    free(b.pages);
+    return -1;
+   }
+ free(b.pages);
+ for (i=from; i<=to; i++)
+     if (bt->frames[i])
+        n++;
+ return n;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the frame at @var{level}, requesting its page if needed.
+
+  Command: -stack-list-frames + -stack-list-arguments (only if needed)
+  Return: The frame or NULL if not available. The frame belongs to the
+backtrace object, don't release it.
+
+***************************************************************************/
+
+mi_frames *gmi_backtrace_frame(mi_h *h, mi_backtrace *bt, int level)
+{
+ if (level<0 || gmi_backtrace_fetch(h,bt,level,level)<=0)
+    return NULL;
+ return bt->frames[level];
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the depth of the stack, limited to the max_depth of the backtrace.
+The truncated field is set if the stack is deeper. Note that gdb must
+unwind the whole stack (up to the limit) to compute it.
+
+  Command: -stack-info-depth (only if not known)
+  Return: The depth or -1 on error.
+
+***************************************************************************/
+
+int gmi_backtrace_depth(mi_h *h, mi_backtrace *bt)
+{
+ int depth;
+
+ mi_backtrace_check(h,bt);
+ if (bt->depth>=0 || bt->truncated)
+    return bt->truncated ? bt->max_depth : bt->depth;
+ /* Ask for one more to know if we are truncating. */
+ depth=gmi_stack_info_depth(h,bt->max_depth+1);
+ if (depth<0)
+    return -1;
+ if (depth>bt->max_depth)
+   {
+    bt->truncated=1;
+    return bt->max_depth;
+   }
+ bt->depth=depth;
+ return depth;
+}
@@ -0,0 +1,622 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Step trace recorder.
+  Comments:
+  Single steps the target and records the pc, the registers that changed
+and some memory ranges at each step in a binary file.@p
+
+  In all-stop mode gdb doesn't read the next command until the step is
+finished, so the step, the register values and the memory reads are sent
+together and the responses are collected in order: one round trip for
+each step. The registers are read in raw format and decoded directly from
+the gdb line (see @x{gmi_data_list_register_values_raw}), the changed ones
+are found comparing the values with the previous step. In non-stop mode
+the queries are sent after the stop.@p
+
+  File format, the numbers are unsigned LEB128 (varint) unless noted:@p
+
+@<pre>
+Header:  "MISTEP" version(byte=1) big_endian(byte) count stride
+         count * register_number
+         nmems nmems * (len exp_len exp_bytes)
+Step:    'S' pc_delta(zig-zag varint) nchanged
+         nchanged * (slot size(byte, 0xFF unavailable) bytes)
+         nmems * (addr state(byte: 0 N/A, 1 same, 2 new) [len bytes])
+End:     'E' stop_reason(byte) steps
+@</pre>
+
+  The same structure is used to read the file, see
+@x{mi_step_trace_open}.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include "mi_gdb.h"
+
+#define MI_STEP_MAGIC "MISTEP"
+#define MI_STEP_VERSION 1
+#define MI_STEP_NA 0xFF
+
+/* From regfile.c */
+void mi_data_list_register_values_n(mi_h *h, enum mi_gvar_fmt fmt,
+                                    const int *regs, int count);
+int mi_raw_parse_values(const char *s, const int *regs, int count,
+                        unsigned char *buf, int stride, int *sizes,
+                        int big_endian);
+/* From data_man.c */
+void mi_data_read_memory_hx(mi_h *h, const char *exp, unsigned ws,
+                            unsigned c, int convAddr);
+/* From prg_control.c */
+void mi_exec_next(mi_h *h, int count);
+void mi_exec_next_instruction(mi_h *h);
+void mi_exec_step(mi_h *h, int count);
+void mi_exec_step_instruction(mi_h *h);
+static
+int mi_step_alloc_regs(mi_step_trace *t)
+{
+ int i;
+
+ t->regs=(int *)mi_calloc(t->count+1,sizeof(int));
+ t->changed=(int *)mi_calloc(t->count+1,sizeof(int));
+ t->sizes=(int *)mi_calloc(t->count+1,sizeof(int));
+ t->psizes=(int *)mi_calloc(t->count+1,sizeof(int));
+ t->vals=(unsigned char *)mi_calloc(t->count+1,t->stride);
+ t->prev=(unsigned char *)mi_calloc(t->count+1,t->stride);
+ if (!t->regs || !t->changed || !t->sizes || !t->psizes || !t->vals ||
+     !t->prev)
+    return 0;
+ /* Nothing known, the first step has all of them. */
+ for (i=0; i<t->count; i++)
+     t->sizes[i]=t->psizes[i]=-2;
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates a recorder that writes to @var{f}. The @var{count} registers
+listed in @var{regs} are recorded, NULL means registers 0 to
+@var{count}-1. Each value uses up to @var{stride} bytes (254 max.), in the
+target byte order indicated by @var{big_endian}. The file isn't closed by
+@x{mi_free_step_trace}.
+
+  Return: A new recorder or NULL on error.
+
+***************************************************************************/
+
+mi_step_trace *mi_new_step_trace(FILE *f, const int *regs, int count,
+                                 int stride, int big_endian)
+{
+ mi_step_trace *t;
+ int i;
+
+ /* The size of each value is stored in a byte, 0xFF is "unavailable". */
+ if (stride>0xFE)
+    return NULL;
+ t=(mi_step_trace *)mi_calloc1(sizeof(mi_step_trace));
+ if (!t)
+    return NULL;
+ t->f=f;
+ t->count=count>0 ? count : 0;
+ t->stride=stride>0 ? stride : 8;
+ t->big_endian=big_endian;
+ if (!mi_step_alloc_regs(t))
+   {
+    mi_free_step_trace(t);
+    return NULL;
+   }
+ for (i=0; i<t->count; i++)
+     t->regs[i]=regs ? regs[i] : i;
+ return t;
+}
+
+void mi_free_step_trace(mi_step_trace *t)
+{
+ mi_step_mem *m, *n;
+
+ if (!t)
+    return;
+ for (m=t->mems; m; m=n)
+    {
+     n=m->next;
+     free(m->exp);
+     free(m->data);
+     free(m->tmp);
+     free(m);
+    }
+ free(t->regs);
+ free(t->changed);
+ free(t->sizes);
+ free(t->psizes);
+ free(t->vals);
+ free(t->prev);
+ free(t);
+}
+
+static
+mi_step_mem *mi_step_new_mem(mi_step_trace *t, char *exp, int len)
+{
+ mi_step_mem *m, **last;
+
+ m=(mi_step_mem *)mi_calloc1(sizeof(mi_step_mem));
+ if (!m)
+   {
+    free(exp);
+    return NULL;
+   }
+ m->exp=exp;
+ m->len=len;
+ m->data=(unsigned char *)mi_calloc(len,1);
+ m->tmp=(unsigned char *)mi_calloc(len,1);
+ if (!m->data || !m->tmp)
+   {
+    free(m->exp);
+    free(m->data);
+    free(m->tmp);
+    free(m);
+    return NULL;
+   }
+ for (last=&t->mems; *last; last=&(*last)->next);
+ *last=m;
+ t->nmems++;
+ return m;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Records @var{len} bytes at the address given by @var{exp} at each step,
+i.e. "$sp" or "&buffer". The expression is evaluated at each step. Must be
+called before the first step.
+
+  Return: !=0 OK
+
+***************************************************************************/
+
+int mi_step_trace_add_mem(mi_step_trace *t, const char *exp, int len)
+{
+ char *e;
+
+ if (t->header || len<=0)
+    return 0;
+ e=(char *)mi_malloc(strlen(exp)+1);
+ if (!e)
+    return 0;
+ strcpy(e,exp);
+ return mi_step_new_mem(t,e,len)!=NULL;
+}
+
+/* Writer. */
+
+static
+void mi_step_put_uv(FILE *f, unsigned long long v)
+{
+ while (v>=0x80)
+   {
+    putc((v & 0x7F) | 0x80,f);
+    v>>=7;
+   }
+ putc(v,f);
+}
+
+static
+int mi_step_write_header(mi_step_trace *t)
+{
+ mi_step_mem *m;
+ int i, l;
+
+ fwrite(MI_STEP_MAGIC,6,1,t->f);
+ putc(MI_STEP_VERSION,t->f);
+ putc(t->big_endian ? 1 : 0,t->f);
+ mi_step_put_uv(t->f,t->count);
+ mi_step_put_uv(t->f,t->stride);
+ for (i=0; i<t->count; i++)
+     mi_step_put_uv(t->f,t->regs[i]);
+ mi_step_put_uv(t->f,t->nmems);
+ for (m=t->mems; m; m=m->next)
+    {
+     l=strlen(m->exp);
+     mi_step_put_uv(t->f,m->len);
+     mi_step_put_uv(t->f,l);
+     fwrite(m->exp,l,1,t->f);
+    }
+ t->header=1;
+ return !ferror(t->f);
+}
+
+/* Finds the changed registers and writes the record. */
+static
+int mi_step_write(mi_step_trace *t, unsigned long long pc)
+{
+ mi_step_mem *m;
+ long long delta=(long long)(pc-t->pc);
+ int i, size;
+ unsigned char *v, *p;
+
+ t->nchanged=0;
+ for (i=0; i<t->count; i++)
+    {
+     v=t->vals+i*t->stride;
+     p=t->prev+i*t->stride;
+     size=t->sizes[i];
+     if (size==t->psizes[i] && (size<0 || memcmp(v,p,size)==0))
+        continue;
+     t->changed[t->nchanged++]=i;
+     t->psizes[i]=size;
+     if (size>0)
+        memcpy(p,v,size);
+    }
+ putc('S',t->f);
+ mi_step_put_uv(t->f,((unsigned long long)delta<<1) ^ (delta<0 ? ~0ULL : 0));
+ t->pc=pc;
+ mi_step_put_uv(t->f,t->nchanged);
+ for (i=0; i<t->nchanged; i++)
+    {
+     size=t->sizes[t->changed[i]];
+     mi_step_put_uv(t->f,t->changed[i]);
+     putc(size<0 ? MI_STEP_NA : size,t->f);
+     if (size>0)
+        fwrite(t->vals+t->changed[i]*t->stride,size,1,t->f);
+    }
+ for (m=t->mems; m; m=m->next)
+    {
+     mi_step_put_uv(t->f,m->addr);
+     putc(m->state,t->f);
+     if (m->state==2)
+        fwrite(m->data,m->len,1,t->f);
+    }
+ t->steps++;
+ return !ferror(t->f);
+}
+
+static
+void mi_step_send(mi_h *h, enum mi_step_mode mode)
+{
+ switch (mode)
+   {
+    case sm_stepi:
+         mi_exec_step_instruction(h);
+         break;
+    case sm_nexti:
+         mi_exec_next_instruction(h);
+         break;
+    case sm_step:
+         mi_exec_step(h,1);
+         break;
+    case sm_next:
+         mi_exec_next(h,1);
+         break;
+   }
+}
+
+static
+void mi_step_send_queries(mi_h *h, mi_step_trace *t)
+{
+ mi_step_mem *m;
+
+ if (t->count)
+   {
+    h->catch_result=1;
+    mi_data_list_register_values_n(h,fm_raw,t->regs,t->count);
+   }
+ for (m=t->mems; m; m=m->next)
+     mi_data_read_memory_hx(h,m->exp,1,m->len,0);
+}
+
+/* Waits for the step, returns the stop or NULL on error. */
+static
+mi_stop *mi_step_wait(mi_h *h)
+{
+ mi_output *o, *sr;
+ mi_stop *st=NULL;
+
+ o=mi_get_response_blk(h);
+ if (!o)
+    return NULL;
+ sr=mi_get_rrecord(o);
+ if (!sr || sr->tclass!=MI_CL_RUNNING)
+   {
+    mi_free_output(o);
+    return NULL;
+   }
+ /* The stop can come in the same response. */
+ if (!mi_get_stop_record(o))
+   {
+    mi_free_output(o);
+    o=mi_get_stop_blk(h);
+    if (!o)
+       return NULL;
+   }
+ sr=mi_get_stop_record(o);
+ st=mi_get_stopped(sr->c);
+ mi_free_output(o);
+ return st;
+}
+
+/* Collects the responses for the queries. */
+static
+int mi_step_get_queries(mi_h *h, mi_step_trace *t)
+{
+ mi_output *r;
+ mi_step_mem *m;
+ unsigned long addr;
+ int i, na, ok=1;
+
+ if (t->count)
+   {
+    for (i=0; i<t->count; i++)
+        t->sizes[i]=-1;
+    r=mi_get_response_blk(h);
+    if (!h->catch_result)
+       ok=mi_raw_parse_values(h->catched_result,t->regs,t->count,t->vals,
+                              t->stride,t->sizes,t->big_endian)>=0;
+    else
+       ok=0;
+    h->catch_result=0;
+    mi_free_output(r);
+   }
+ for (m=t->mems; m; m=m->next)
+    {
+     addr=0;
+     if (!mi_get_read_memory(h,m->tmp,1,&na,&addr) || na)
+        m->state=0;
+     else if (m->state && addr==m->addr && memcmp(m->tmp,m->data,m->len)==0)
+        m->state=1;
+     else
+       {
+        memcpy(m->data,m->tmp,m->len);
+        m->state=2;
+       }
+     m->addr=addr;
+    }
+ return ok;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Records up to @var{steps} steps of the current thread. The @var{mode}
+selects the command used for each step: sm_stepi, sm_nexti, sm_step or
+sm_next. After each step @var{cb} is called (if not NULL), returning 0
+stops the recording. The recording also stops if the target stops for
+other reason, i.e. a breakpoint or a signal. An end record is written
+with the last stop reason, available in the @var{reason} field. Not
+supported in non-stop mode, a stop from other thread can't be told from the
+end of the step.
+
+  Command: -exec-step-instruction (or the other modes) +
+-data-list-register-values r + -data-read-memory
+  Return: The number of steps recorded or -1 on error (MI_UNSUPPORTED in
+non-stop mode).
+
+***************************************************************************/
+
+int gmi_step_trace_run(mi_h *h, mi_step_trace *t, enum mi_step_mode mode,
+                       int steps, mi_step_cb cb, void *data)
+{
+ mi_stop *st;
+ unsigned long long pc;
+ int n=0, ok=1, exited;
+
+ if (h->non_stop)
+   {
+    mi_error=MI_UNSUPPORTED;
+    return -1;
+   }
+ if (!t->header && !mi_step_write_header(t))
+    return -1;
+ t->reason=sr_unknown;
+ while (n<steps && ok)
+   {
+    mi_error=MI_OK;
+    mi_step_send(h,mode);
+    /* gdb reads the queries after the step is finished. */
+    mi_step_send_queries(h,t);
+    st=mi_step_wait(h);
+    if (!st)
+      {
+       if (mi_error!=MI_GDB_DIED && mi_error!=MI_GDB_TIME_OUT)
+          /* The step failed, discard the queries. */
+          mi_step_get_queries(h,t);
+       h->catch_result=0;
+       ok=0;
+       break;
+      }
+    t->reason=st->reason;
+    exited=st->reason==sr_exited_signalled || st->reason==sr_exited ||
+           st->reason==sr_exited_normally;
+    pc=st->frame ? (unsigned long)st->frame->addr : 0;
+    mi_free_stop(st);
+    if (exited)
+      {/* The queries fail, just discard them. */
+       mi_step_get_queries(h,t);
+       h->catch_result=0;
+       break;
+      }
+    if (!mi_step_get_queries(h,t))
+      {
+       ok=0;
+       break;
+      }
+    if (!mi_step_write(t,pc))
+      {
+       ok=0;
+       break;
+      }
+    n++;
+    if (t->reason!=sr_end_stepping_range || (cb && !cb(t,data)))
+       break;
+   }
+ putc('E',t->f);
+ putc(t->reason,t->f);
+ mi_step_put_uv(t->f,n);
+ fflush(t->f);
+ return ok && !ferror(t->f) ? n : -1;
+}
+
+/* Reader. */
+
+static
+int mi_step_get_uv(FILE *f, unsigned long long *v)
+{
+ int c, shift=0;
+
+ *v=0;
+ do
+   {
+    c=getc(f);
+    if (c==EOF || shift>63)
+       return 0;
+    *v|=(unsigned long long)(c & 0x7F)<<shift;
+    shift+=7;
+   }
+ while (c & 0x80);
+ return 1;
+}
+
+static
+int mi_step_get_int(FILE *f, int *v, int max)
+{
+ unsigned long long l;
+
+ if (!mi_step_get_uv(f,&l) || l>(unsigned long long)max)
+    return 0;
+ *v=(int)l;
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Reads the header of a file created by @x{gmi_step_trace_run}. Use
+@x{mi_step_trace_next} to read the steps.
+
+  Return: A new mi_step_trace or NULL on error. Release it using
+@x{mi_free_step_trace}.
+
+***************************************************************************/
+
+mi_step_trace *mi_step_trace_open(FILE *f)
+{
+ mi_step_trace *t;
+ char magic[8];
+ int i, n, len, l;
+ char *exp;
+
+ if (fread(magic,8,1,f)!=1 || memcmp(magic,MI_STEP_MAGIC,6) ||
+     magic[6]!=MI_STEP_VERSION)
+   {
+    mi_error=MI_PARSER;
+    return NULL;
+   }
+ t=(mi_step_trace *)mi_calloc1(sizeof(mi_step_trace));
+ if (!t)
+    return NULL;
+ t->f=f;
+ t->big_endian=magic[7];
+ t->header=1;
+ if (!mi_step_get_int(f,&t->count,0xFFFF) ||
+     !mi_step_get_int(f,&t->stride,0xFE) || !mi_step_alloc_regs(t))
+    goto error;
+ for (i=0; i<t->count; i++)
+     if (!mi_step_get_int(f,t->regs+i,0xFFFF))
+        goto error;
+ if (!mi_step_get_int(f,&n,0xFFFF))
+    goto error;
+ for (i=0; i<n; i++)
+    {
+     if (!mi_step_get_int(f,&len,0xFFFFFF) || !len ||
+         !mi_step_get_int(f,&l,0xFFFF))
+        goto error;
+     exp=(char *)mi_malloc(l+1);
+     if (!exp || fread(exp,1,l,f)!=(size_t)l)
+       {
+        free(exp);
+        goto error;
+       }
+     exp[l]=0;
+     if (!mi_step_new_mem(t,exp,len))
+        goto error;
+    }
+ return t;
+
+error:
+ if (mi_error==MI_OK)
+    mi_error=MI_PARSER;
+ mi_free_step_trace(t);
+ return NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Reads the next record. For a step the pc, vals, sizes (-1 unavailable),
+changed and mems fields are updated. The end of each recording returns 0
+and sets reason.
+
+  Return: 1 for a step, 0 for the end of a recording, -1 at the end of the
+file or on error.
+
+***************************************************************************/
+
+int mi_step_trace_next(mi_step_trace *t)
+{
+ unsigned long long delta, addr;
+ mi_step_mem *m;
+ int c, i, slot, size;
+
+ c=getc(t->f);
+ if (c=='E')
+   {
+    c=getc(t->f);
+    if (c==EOF || !mi_step_get_uv(t->f,&delta))
+       return -1;
+    t->reason=c;
+    return 0;
+   }
+ if (c!='S' || !mi_step_get_uv(t->f,&delta) ||
+     !mi_step_get_int(t->f,&t->nchanged,t->count))
+    return -1;
+ t->pc+=(delta>>1) ^ (delta & 1 ? ~0ULL : 0);
+ for (i=0; i<t->nchanged; i++)
+    {
+     if (!mi_step_get_int(t->f,&slot,t->count-1) ||
+         (size=getc(t->f))==EOF)
+        return -1;
+     t->changed[i]=slot;
+     if (size==MI_STEP_NA)
+        size=-1;
+     else if (size>t->stride ||
+              (size && fread(t->vals+slot*t->stride,size,1,t->f)!=1))
+        return -1;
+     t->sizes[slot]=size;
+    }
+ for (m=t->mems; m; m=m->next)
+    {
+     if (!mi_step_get_uv(t->f,&addr) || (c=getc(t->f))==EOF)
+        return -1;
+     m->addr=addr;
+     m->state=c;
+     if (c==2 && fread(m->data,m->len,1,t->f)!=1)
+        return -1;
+    }
+ t->steps++;
+ return 1;
+}
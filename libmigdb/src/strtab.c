@@ -0,0 +1,232 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: String table.
+  Comments:
+  Interns strings, each different string is stored only once and gets a
+small integer id. Used when we need to keep a lot of repeated names, i.e.
+function and file names for stack samples, so we can store ids instead of
+pointers to malloced copies.@p
+
+  The strings are stored in big blocks, so the pointers returned by
+@x{mi_strtab_str} are valid until the table is released.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include "mi_gdb.h"
+
+#define MI_STRTAB_BLOCK  4096
+#define MI_STRTAB_SLOTS  64
+
+struct mi_strtab_blk_struct
+{
+ int size, used;
+ struct mi_strtab_blk_struct *next;
+ char data[1];
+};
+
+static
+unsigned mi_strtab_hash(const char *s)
+{
+ unsigned hash=2166136261u;
+
+ for (; *s; s++)
+    {
+     hash^=(unsigned char)*s;
+     hash*=16777619u;
+    }
+ return hash;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates an empty string table.
+
+  Return: A new table or NULL on error. Release it using
+@x{mi_free_strtab}.
+
+***************************************************************************/
+
+mi_strtab *mi_new_strtab()
+{
+ mi_strtab *t=(mi_strtab *)mi_calloc1(sizeof(mi_strtab));
+
+ if (!t)
+    return NULL;
+ t->buckets=MI_STRTAB_SLOTS;
+ t->table=(int *)mi_malloc(t->buckets*sizeof(int));
+ if (!t->table)
+   {
+    free(t);
+    return NULL;
+   }
+ memset(t->table,0xFF,t->buckets*sizeof(int));
+ return t;
+}
+
+void mi_free_strtab(mi_strtab *t)
+{
+ mi_strtab_blk *b, *n;
+
+ if (!t)
+    return;
+ for (b=t->blks; b; b=n)
+    {
+     n=b->next;
+     free(b);
+    }
+ free(t->strs);
+ free(t->table);
+ free(t);
+}
+
+/* Open addressing with linear probing, returns the slot for s. */
+static
+int mi_strtab_slot(mi_strtab *t, const char *s, unsigned hash)
+{
+ int i=hash & (t->buckets-1), id;
+
+ while ((id=t->table[i])>=0 && strcmp(t->strs[id],s))
+    i=(i+1) & (t->buckets-1);
+ return i;
+}
+
+static
+int mi_strtab_grow(mi_strtab *t)
+{
+ int nb=t->buckets*2, i, j, *nt;
+
+ nt=(int *)mi_malloc(nb*sizeof(int));
+ if (!nt)
+    return 0;
+ memset(nt,0xFF,nb*sizeof(int));
+ for (i=0; i<t->count; i++)
+    {
+     j=mi_strtab_hash(t->strs[i]) & (nb-1);
+     while (nt[j]>=0)
+        j=(j+1) & (nb-1);
+     nt[j]=i;
+    }
+ free(t->table);
+ t->table=nt;
+ t->buckets=nb;
+ return 1;
+}
+
+/* Copies s to the blocks. */
+static
+char *mi_strtab_store(mi_strtab *t, const char *s)
+{
+ int len=strlen(s)+1;
+ mi_strtab_blk *b=t->blks;
+ char *d;
+
+ if (!b || b->used+len>b->size)
+   {
+    int size=len>MI_STRTAB_BLOCK ? len : MI_STRTAB_BLOCK;
+    b=(mi_strtab_blk *)mi_malloc(sizeof(mi_strtab_blk)+size);
+    if (!b)
+       return NULL;
+    b->size=size;
+    b->used=0;
+    b->next=t->blks;
+    t->blks=b;
+   }
+ d=b->data+b->used;
+ memcpy(d,s,len);
+ b->used+=len;
+ return d;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Looks for @var{s} in the table.
+
+  Return: The id of the string or -1 if not in the table.
+
+***************************************************************************/
+
+int mi_strtab_find(mi_strtab *t, const char *s)
+{
+ return t->table[mi_strtab_slot(t,s,mi_strtab_hash(s))];
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Adds @var{s} to the table, if it isn't already there. The ids are
+consecutive, starting from 0.
+
+  Return: The id of the string or -1 on error.
+
+***************************************************************************/
+
+int mi_strtab_intern(mi_strtab *t, const char *s)
+{
+ unsigned hash=mi_strtab_hash(s);
+ int i=mi_strtab_slot(t,s,hash);
+ char *d;
+
+ if (t->table[i]>=0)
+    return t->table[i];
+ /* Keep the load under 50%. */
+ if ((t->count+1)*2>t->buckets)
+   {
+    if (!mi_strtab_grow(t))
+       return -1;
+    i=mi_strtab_slot(t,s,hash);
+   }
+ if (t->count>=t->size)
+   {
+    int ns=t->size ? t->size*2 : MI_STRTAB_SLOTS;
+    char **n=(char **)realloc(t->strs,ns*sizeof(char *));
+    if (!n)
+      {
+       mi_error=MI_OUT_OF_MEMORY;
+       return -1;
+      }
+    t->strs=n;
+    t->size=ns;
+   }
+ d=mi_strtab_store(t,s);
+ if (!d)
+    return -1;
+ t->strs[t->count]=d;
+ t->table[i]=t->count;
+ return t->count++;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the string for the @var{id}.
+
+  Return: The string or NULL if the id is invalid.
+
+***************************************************************************/
+
+const char *mi_strtab_str(mi_strtab *t, int id)
+{
+ if (id<0 || id>=t->count)
+    return NULL;
+ return t->strs[id];
+}
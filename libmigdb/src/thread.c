@@ -23,12 +23,16 @@
 
 @<pre>
 gdb command:              Implemented?
--thread-info              N.A.
+-thread-info              Yes
 -thread-list-all-threads  Yes, implemented as "info threads"
 -thread-list-ids          Yes
 -thread-select            Yes
 @</pre>
 
+  The stacks of all the threads can be collected using
+@x{gmi_thread_all_stacks}, the -stack-list-frames for each thread are sent
+in a pipeline using the --thread option, so we don't need to select them.@p
+
 ***************************************************************************/
 
 #include "mi_gdb.h"
@@ -50,6 +54,19 @@ void mi_thread_list_all_threads(mi_h *h)
  mi_send(h,"info threads\n");
 }
 
+void mi_thread_info(mi_h *h, int id)
+{
+ if (id<0)
+    mi_send(h,"-thread-info\n");
+ else
+    mi_send(h,"-thread-info %d\n",id);
+}
+
+/* From stack_man.c */
+void mi_stack_list_frames_t(mi_h *h, int thread, int from, int to);
+/* From connect.c */
+void mi_set_thread_states(mi_h *h, mi_thread *l);
+
 /* High level versions. */
 
 /**[txh]********************************************************************
@@ -80,6 +97,7 @@ int gmi_thread_list_ids(mi_h *h, int **list)
 
 mi_frames *gmi_thread_select(mi_h *h, int id)
 {
+ mi_selection_changed(h,1);
  mi_thread_select(h,id);
  return mi_res_frame(h);
 }
@@ -101,3 +119,114 @@ mi_frames *gmi_thread_list_all_threads(mi_h *h)
  return mi_res_frames_list(h);
 }
 
+
+/**[txh]********************************************************************
+
+  Description:
+  Get information about all the threads: id, target id, name, state, core
+and current frame. @var{current} is filled with the id of the current
+thread, it can be NULL. The run state table (@x{mi_get_thread_state}) is
+refreshed. Needs gdb 7.0 or newer, for older versions use
+@x{gmi_thread_list_all_threads}.
+
+  Command: -thread-info
+  Return: A new list of mi_thread or NULL on error (or if no threads).
+
+***************************************************************************/
+
+mi_thread *gmi_thread_info(mi_h *h, int *current)
+{
+ mi_thread *l;
+
+ mi_error=MI_OK;
+ mi_thread_info(h,-1);
+ l=mi_res_thread_info(h,current);
+ if (mi_error==MI_OK)
+    mi_set_thread_states(h,l);
+ return l;
+}
+
+typedef struct
+{
+ mi_thread **ths;
+ int max_depth;
+} mi_thread_batch;
+
+static
+void mi_thread_batch_send(mi_h *h, int i, void *data)
+{
+ mi_thread_batch *b=(mi_thread_batch *)data;
+
+ if (b->max_depth>0)
+    mi_stack_list_frames_t(h,b->ths[i]->id,0,b->max_depth-1);
+ else
+    mi_stack_list_frames_t(h,b->ths[i]->id,-1,-1);
+}
+
+static
+int mi_thread_batch_recv(mi_h *h, int i, void *data)
+{
+ mi_thread *t=((mi_thread_batch *)data)->ths[i];
+
+ mi_free_frames(t->stack);
+ t->stack=mi_res_frames_array(h,"stack");
+ return t->stack!=NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Fills the stack field for the stopped threads in the @var{l} list. Only
+the innermost @var{max_depth} frames are requested, use -1 for all. The
+commands are sent in a pipeline (@x{mi_pipeline}).
+
+  Command: -stack-list-frames --thread
+  Return: The number of stacks obtained or -1 on error.
+
+***************************************************************************/
+
+int gmi_thread_list_stacks(mi_h *h, mi_thread *l, int max_depth)
+{
+ mi_thread_batch b;
+ mi_thread *t;
+ int n=0, ok;
+
+ for (t=l; t; t=t->next)
+     if (!t->running)
+        n++;
+ if (!n)
+    return 0;
+ b.max_depth=max_depth;
+ b.ths=(mi_thread **)mi_calloc(n,sizeof(mi_thread *));
+ if (!b.ths)
+    return -1;
+ for (n=0, t=l; t; t=t->next)
+     if (!t->running)
+        b.ths[n++]=t;
+ ok=mi_pipeline(h,n,mi_thread_batch_send,mi_thread_batch_recv,&b);
+ free(b.ths);
+ return ok;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the information and the stack of all the threads in two round trips,
+see @x{gmi_thread_info} and @x{gmi_thread_list_stacks}.
+
+  Command: -thread-info + -stack-list-frames --thread
+  Return: A new list of mi_thread or NULL on error.
+
+***************************************************************************/
+
+mi_thread *gmi_thread_all_stacks(mi_h *h, int max_depth, int *current)
+{
+ mi_thread *l=gmi_thread_info(h,current);
+
+ if (l && gmi_thread_list_stacks(h,l,max_depth)<0)
+   {
+    mi_free_threads(l);
+    l=NULL;
+   }
+ return l;
+}
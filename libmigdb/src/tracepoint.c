@@ -0,0 +1,368 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Tracepoints.
+  Comments:
+  GDB/MI commands for the "Tracepoint Commands" section. A tracepoint
+collects data without stopping the target, the data is examined later
+selecting the trace frames. Only targets that support tracing can do it,
+i.e. gdbserver.@p
+
+  The tracepoints are breakpoints, they are deleted, enabled, etc. with the
+-break-* commands. The actions are set with @x{gmi_break_commands}.@p
+
+@<pre>
+gdb command:              Implemented?
+
+-trace-find               Yes
+-trace-define-variable    No
+-trace-frame-collected    Yes
+-trace-list-variables     No
+-trace-save               No
+-trace-start              Yes
+-trace-status             No
+-trace-stop               Yes
+@</pre>
+
+***************************************************************************/
+
+#include <string.h>
+#include "mi_gdb.h"
+
+/* From parse.c */
+mi_chg_reg *mi_parse_reg_values_l(mi_results *r, int *how_many);
+
+static
+const char *mi_tfind_modes[]=
+{
+ "none",
+ "frame-number",
+ "tracepoint-number",
+ "pc",
+ "pc-inside-range",
+ "pc-outside-range",
+ "line"
+};
+
+/* Low level versions. */
+
+void mi_trace_insert(mi_h *h, const char *cond, const char *where)
+{
+ if (cond)
+    mi_send(h,"-break-insert -a -c \"%s\" %s\n",cond,where);
+ else
+    mi_send(h,"-break-insert -a %s\n",where);
+}
+
+void mi_trace_start(mi_h *h)
+{
+ mi_send(h,"-trace-start\n");
+}
+
+void mi_trace_stop(mi_h *h)
+{
+ mi_send(h,"-trace-stop\n");
+}
+
+void mi_trace_find(mi_h *h, enum mi_tfind_mode mode, const char *arg)
+{
+ mi_send(h,"-trace-find %s %s\n",mi_tfind_modes[mode],arg ? arg : "");
+}
+
+void mi_trace_frame_collected(mi_h *h)
+{
+ mi_send(h,"-trace-frame-collected --var-print-values 1 "
+         "--comp-print-values 1 --registers-format x --memory-contents\n");
+}
+
+/* Parsers. */
+
+static
+mi_trace_frame *mi_res_trace_find(mi_h *h)
+{
+ mi_output *r, *res;
+ mi_results *c;
+ mi_trace_frame *f=NULL;
+
+ r=mi_get_response_blk(h);
+ res=mi_get_rrecord(r);
+ if (res && res->tclass==MI_CL_DONE)
+   {
+    f=(mi_trace_frame *)mi_calloc1(sizeof(mi_trace_frame));
+    if (f)
+      {
+       f->traceframe=f->tracepoint=-1;
+       for (c=res->c; c; c=c->next)
+          {
+           if (!c->var)
+              continue;
+           if (c->type==t_const && strcmp(c->var,"traceframe")==0)
+              f->traceframe=atoi(c->v.cstr);
+           else if (c->type==t_const && strcmp(c->var,"tracepoint")==0)
+              f->tracepoint=atoi(c->v.cstr);
+           else if (c->type==t_tuple && strcmp(c->var,"frame")==0 &&
+                    !f->frame)
+              f->frame=mi_parse_frame(c->v.rs);
+          }
+      }
+   }
+ mi_free_output(r);
+ return f;
+}
+
+/* Moves the list from the result to dest. */
+static
+void mi_trace_steal(mi_results *c, mi_results **dest)
+{
+ if (c->type==t_const)
+    return;
+ mi_free_results(*dest);
+ *dest=c->v.rs;
+ c->v.rs=NULL;
+}
+
+static
+int mi_res_trace_collected(mi_h *h, mi_trace_frame *f)
+{
+ mi_output *r, *res;
+ mi_results *c;
+ int ok=0;
+
+ r=mi_get_response_blk(h);
+ res=mi_get_rrecord(r);
+ if (res && res->tclass==MI_CL_DONE)
+   {
+    ok=1;
+    for (c=res->c; c; c=c->next)
+       {
+        if (!c->var)
+           continue;
+        if (strcmp(c->var,"explicit-variables")==0)
+           mi_trace_steal(c,&f->vars);
+        else if (strcmp(c->var,"computed-expressions")==0)
+           mi_trace_steal(c,&f->exps);
+        else if (strcmp(c->var,"tvars")==0)
+           mi_trace_steal(c,&f->tvars);
+        else if (strcmp(c->var,"memory")==0)
+           mi_trace_steal(c,&f->memory);
+        else if (strcmp(c->var,"registers")==0 && c->type==t_list)
+          {
+           mi_free_chg_reg(f->regs);
+           f->regs=mi_parse_reg_values_l(c->v.rs,&f->nregs);
+          }
+       }
+   }
+ mi_free_output(r);
+ return ok;
+}
+
+/* High level versions. */
+
+/**[txh]********************************************************************
+
+  Description:
+  Insert a tracepoint at @var{where}. The @var{cond} condition is
+optional, it's evaluated by the target.
+
+  Command: -break-insert -a
+  Return: A new mi_bkpt structure with info about the tracepoint. NULL on
+error.
+
+***************************************************************************/
+
+mi_bkpt *gmi_trace_insert(mi_h *h, const char *cond, const char *where)
+{
+ mi_trace_insert(h,cond,where);
+ return mi_res_bkpt(h);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Starts collecting data. The tracepoints are sent to the target.
+
+  Command: -trace-start
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_trace_start(mi_h *h)
+{
+ mi_trace_start(h);
+ return mi_res_simple_done(h);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Stops collecting data.
+
+  Command: -trace-stop
+  Return: The number of trace frames collected or -1 on error.
+
+***************************************************************************/
+
+int gmi_trace_stop(mi_h *h)
+{
+ mi_results *r;
+ int frames=-1;
+
+ mi_trace_stop(h);
+ r=mi_res_done_var(h,"frames");
+ if (r && r->type==t_const)
+    frames=atoi(r->v.cstr);
+ mi_free_results(r);
+ return frames;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Selects a trace frame. The @var{arg} depends on the @var{mode}: the
+frame number for tf_frame, the tracepoint number for tf_tracepoint, an
+address for tf_pc, two addresses separated by a space for tf_pc_inside and
+tf_pc_outside and a location for tf_line. Use tf_none to go back to the
+live target.
+
+  Command: -trace-find
+  Return: A new mi_trace_frame, the traceframe field is -1 if no frame was
+found. NULL on error. Release it using @x{mi_free_trace_frame}.
+
+***************************************************************************/
+
+mi_trace_frame *gmi_trace_find(mi_h *h, enum mi_tfind_mode mode,
+                               const char *arg)
+{
+ mi_trace_find(h,mode,arg);
+ return mi_res_trace_find(h);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the data collected in the selected trace frame and stores it in
+@var{f}. The registers are in hexadecimal and the memory contents are
+included.
+
+  Command: -trace-frame-collected
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_trace_frame_collected(mi_h *h, mi_trace_frame *f)
+{
+ mi_trace_frame_collected(h);
+ return mi_res_trace_collected(h,f);
+}
+
+typedef struct
+{
+ int first;
+ mi_trace_frame **frames;
+} mi_trace_batch;
+
+static
+void mi_trace_send(mi_h *h, int i, void *data)
+{
+ mi_trace_batch *b=(mi_trace_batch *)data;
+ char n[32];
+
+ if (i & 1)
+    mi_trace_frame_collected(h);
+ else
+   {
+    snprintf(n,32,"%d",b->first+i/2);
+    mi_trace_find(h,tf_frame,n);
+   }
+}
+
+static
+int mi_trace_recv(mi_h *h, int i, void *data)
+{
+ mi_trace_batch *b=(mi_trace_batch *)data;
+
+ if (i & 1)
+   {
+    if (b->frames[i/2])
+       return mi_res_trace_collected(h,b->frames[i/2]);
+    /* The frame wasn't found, but we must consume the reply. */
+    mi_res_simple_done(h);
+    return 0;
+   }
+ b->frames[i/2]=mi_res_trace_find(h);
+ return b->frames[i/2]!=NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets @var{count} trace frames, starting at @var{first}, with the
+collected data. The -trace-find and -trace-frame-collected commands for
+all the frames are sent in a pipeline. The last frame remains selected,
+use tf_none to go back to the live target.
+
+  Command: -trace-find frame-number + -trace-frame-collected
+  Return: A list of mi_trace_frame, in order, only the frames that were
+found. Release it using @x{mi_free_trace_frame}.
+
+***************************************************************************/
+
+mi_trace_frame *gmi_trace_get_frames(mi_h *h, int first, int count)
+{
+ mi_trace_batch b;
+ mi_trace_frame *l=NULL, **last=&l;
+ int i;
+
+ if (count<=0)
+    return NULL;
+ b.first=first;
+ b.frames=(mi_trace_frame **)mi_calloc(count,sizeof(mi_trace_frame *));
+ if (!b.frames)
+    return NULL;
+ mi_pipeline(h,count*2,mi_trace_send,mi_trace_recv,&b);
+ for (i=0; i<count; i++)
+    {
+     if (b.frames[i] && b.frames[i]->traceframe>=0)
+       {
+        *last=b.frames[i];
+        last=&b.frames[i]->next;
+       }
+     else
+        mi_free_trace_frame(b.frames[i]);
+    }
+ free(b.frames);
+ return l;
+}
+
+void mi_free_trace_frame(mi_trace_frame *f)
+{
+ mi_trace_frame *n;
+
+ for (; f; f=n)
+    {
+     n=f->next;
+     mi_free_frames(f->frame);
+     mi_free_results(f->vars);
+     mi_free_results(f->exps);
+     mi_free_results(f->tvars);
+     mi_free_results(f->memory);
+     mi_free_chg_reg(f->regs);
+     free(f);
+    }
+}
@@ -40,13 +40,15 @@ gdb command:              Imp? Description:
 Notes:@p
 1) I suggest letting gdb to choose the names for the variables.@*
 2) -var-list-children supports an optional "show values" argument in MI v2.
-It isn't implemented.@*
+It's used when the MI version is forced to v2 and always by
+@x{gmi_var_expand}.@*
 @p
 
 * MI v1 and v2 result formats supported.@p
 
 ***************************************************************************/
 
+#include <string.h>
 #include "mi_gdb.h"
 
 /* Low level versions. */
@@ -104,6 +106,12 @@ void mi_var_update(mi_h *h, const char *name)
     mi_send(h,"-var-update *\n");
 }
 
+/* show: 1 all values, 2 simple values (not for structs, arrays, etc.) */
+void mi_var_update_v(mi_h *h, const char *name, int show)
+{
+ mi_send(h,"-var-update %d %s\n",show,name ? name : "*");
+}
+
 void mi_var_assign(mi_h *h, const char *name, const char *expression)
 {
  mi_send(h,"-var-assign \"%s\" \"%s\"\n",name,expression);
@@ -122,6 +130,16 @@ void mi_var_list_children(mi_h *h, const char *name)
     mi_send(h,"-var-list-children \"%s\"\n",name);
 }
 
+/* Children with values, from/to is a range of children, -1 for all. */
+void mi_var_list_children_r(mi_h *h, const char *name, int from, int to)
+{
+ if (from<0)
+    mi_send(h,"-var-list-children --all-values \"%s\"\n",name);
+ else
+    mi_send(h,"-var-list-children --all-values \"%s\" %d %d\n",name,from,
+            to);
+}
+
 /* High level versions. */
 
 /**[txh]********************************************************************
@@ -176,7 +194,9 @@ int gmi_var_delete(mi_h *h, mi_gvar *var)
 /**[txh]********************************************************************
 
   Description:
-  Set the format used to represent the result.
+  Set the format used to represent the result. New gdb versions also
+report the value using the new format, in this case the value field is
+updated, no need to evaluate it again.
 
   Command: -var-set-format
   Return: !=0 OK
@@ -188,7 +208,7 @@ int gmi_var_set_format(mi_h *h, mi_gvar *var, enum mi_gvar_fmt format)
  int ret;
 
  mi_var_set_format(h,var->name,mi_format_enum_to_str(format));
- ret=mi_res_simple_done(h);
+ ret=mi_res_gvar(h,var,NULL)!=NULL;
  if (ret)
     var->format=format;
  return ret;
@@ -316,6 +336,26 @@ int gmi_var_update(mi_h *h, mi_gvar *var, mi_gvar_chg **changed)
  return mi_res_changelist(h,changed);
 }
 
+/**[txh]********************************************************************
+
+  Description:
+  Update variable. Use NULL for all. The value field of the changes
+contains the new value. If @var{simple} is !=0 the values of structures,
+arrays and unions aren't reported. This avoids one
+@x{gmi_var_evaluate_expression} for each changed variable.
+
+  Command: -var-update --all-values/--simple-values
+  Return: !=0 OK. The @var{changed} list contains the list of changed vars.
+
+***************************************************************************/
+
+int gmi_var_update_values(mi_h *h, mi_gvar *var, int simple,
+                          mi_gvar_chg **changed)
+{
+ mi_var_update_v(h,var ? var->name : NULL,simple ? 2 : 1);
+ return mi_res_changelist(h,changed);
+}
+
 /**[txh]********************************************************************
 
   Description:
@@ -329,6 +369,8 @@ int gmi_var_update(mi_h *h, mi_gvar *var, mi_gvar_chg **changed)
 int gmi_var_assign(mi_h *h, mi_gvar *var, const char *expression)
 {
  char *res;
+ /* The target memory changes. */
+ mi_invalidate_caches(h);
  mi_var_assign(h,var->name,expression);
  res=mi_res_value(h);
  if (res)
@@ -381,3 +423,89 @@ int gmi_var_list_children(mi_h *h, mi_gvar *var)
  return mi_res_children(h,var);
 }
 
+
+static
+void mi_var_expand_send(mi_h *h, int i, void *data)
+{
+ mi_var_list_children_r(h,((mi_gvar **)data)[i]->name,-1,-1);
+}
+
+static
+int mi_var_expand_recv(mi_h *h, int i, void *data)
+{
+ return mi_res_children(h,((mi_gvar **)data)[i]);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Expands the @var{var} subtree, level by level. For each level the
+children of all the nodes are requested in a pipeline, so the cost is a
+few round trips instead of one for each node. @var{max_depth} limits the
+number of levels and @var{max_nodes} the number of children fetched, use 0
+for no limit. Pointers aren't followed, use this function again to expand
+them.
+
+  Command: -var-list-children --all-values
+  Return: The number of nodes fetched or -1 on error.
+
+***************************************************************************/
+
+int gmi_var_expand(mi_h *h, mi_gvar *var, int max_depth, int max_nodes)
+{
+ mi_gvar **cur, **next, **aux, *c;
+ int ncur=1, nnext, anext, fetched=0, got=0, level=0, i, n;
+
+ cur=(mi_gvar **)mi_malloc(sizeof(mi_gvar *));
+ if (!cur)
+    return -1;
+ cur[0]=var;
+ while (ncur && (max_depth<=0 || level<max_depth))
+   {
+    /* Take the nodes that fit in the budget. */
+    for (i=n=0; i<ncur; i++)
+       {
+        if (max_nodes>0 && fetched+cur[i]->numchild>max_nodes)
+           continue;
+        fetched+=cur[i]->numchild;
+        cur[n++]=cur[i];
+       }
+    if (!n)
+       break;
+    if (mi_pipeline(h,n,mi_var_expand_send,mi_var_expand_recv,cur)<0)
+      {
+       free(cur);
+       return -1;
+      }
+    /* The next level. */
+    next=NULL;
+    nnext=anext=0;
+    for (i=0; i<n; i++)
+        for (c=cur[i]->child; c; c=c->next)
+           {
+            got++;
+            if (!c->numchild || c->ispointer)
+               continue;
+            if (nnext==anext)
+              {
+               anext=anext ? anext*2 : 64;
+               aux=(mi_gvar **)realloc(next,anext*sizeof(mi_gvar *));
+               if (!aux)
+                 {
+                  mi_error=MI_OUT_OF_MEMORY;
+                  free(next);
+                  free(cur);
+                  return -1;
+                 }
+               next=aux;
+              }
+            next[nnext++]=c;
+           }
+    free(cur);
+    cur=next;
+    ncur=nnext;
+    level++;
+   }
+ free(cur);
+ return got;
+}
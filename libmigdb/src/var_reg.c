@@ -0,0 +1,425 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Variable objects registry.
+  Comments:
+  Owns all the variable objects of a session and indexes them by the name
+gdb assigned, using a hash table chained with the hnext field. The list
+of changes reported by -var-update is applied directly to the nodes, so
+the cost depends on the number of changes, not on the number of
+variables.@p
+
+  The children must be fetched using the gmi_var_reg_* functions, they
+free the old children and the registry must know it.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include "mi_gdb.h"
+
+#define MI_VREG_SLOTS 256
+
+/* From var_obj.c */
+void mi_var_update_v(mi_h *h, const char *name, int show);
+
+static
+unsigned mi_vreg_hash(const char *s)
+{
+ unsigned hash=2166136261u;
+
+ for (; *s; s++)
+    {
+     hash^=(unsigned char)*s;
+     hash*=16777619u;
+    }
+ return hash;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates an empty registry.
+
+  Return: A new registry or NULL on error. Release it using
+@x{mi_free_var_reg}.
+
+***************************************************************************/
+
+mi_var_reg *mi_new_var_reg()
+{
+ mi_var_reg *r=(mi_var_reg *)mi_calloc1(sizeof(mi_var_reg));
+
+ if (!r)
+    return NULL;
+ r->buckets=MI_VREG_SLOTS;
+ r->table=(mi_gvar **)mi_calloc(r->buckets,sizeof(mi_gvar *));
+ if (!r->table)
+   {
+    free(r);
+    return NULL;
+   }
+ return r;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Releases the registry and all the variables it owns. The variable
+objects aren't deleted in gdb.
+
+***************************************************************************/
+
+void mi_free_var_reg(mi_var_reg *r)
+{
+ if (!r)
+    return;
+ mi_free_gvar(r->roots);
+ free(r->table);
+ free(r->chg);
+ free(r);
+}
+
+static
+void mi_vreg_grow(mi_var_reg *r)
+{
+ int nb=r->buckets*2, i;
+ mi_gvar **nt=(mi_gvar **)calloc(nb,sizeof(mi_gvar *)), *v, *n;
+ unsigned j;
+
+ /* Not fatal, the chains just get longer. */
+ if (!nt)
+    return;
+ for (i=0; i<r->buckets; i++)
+     for (v=r->table[i]; v; v=n)
+        {
+         n=v->hnext;
+         j=mi_vreg_hash(v->name) & (nb-1);
+         v->hnext=nt[j];
+         nt[j]=v;
+        }
+ free(r->table);
+ r->table=nt;
+ r->buckets=nb;
+}
+
+/* Adds v and all its descendants to the index. */
+static
+void mi_vreg_index(mi_var_reg *r, mi_gvar *v)
+{
+ unsigned i;
+
+ if (!v->name)
+    return;
+ if (r->count>=r->buckets)
+    mi_vreg_grow(r);
+ i=mi_vreg_hash(v->name) & (r->buckets-1);
+ v->hnext=r->table[i];
+ r->table[i]=v;
+ r->count++;
+ for (v=v->child; v; v=v->next)
+     mi_vreg_index(r,v);
+}
+
+/* Removes v and all its descendants from the index. */
+static
+void mi_vreg_unindex(mi_var_reg *r, mi_gvar *v)
+{
+ mi_gvar **p;
+ int i;
+
+ if (!v->name)
+    return;
+ for (p=r->table+(mi_vreg_hash(v->name) & (r->buckets-1)); *p;
+      p=&(*p)->hnext)
+     if (*p==v)
+       {
+        *p=v->hnext;
+        r->count--;
+        break;
+       }
+ /* It could be released, forget it. */
+ if (v->changed)
+    for (i=0; i<r->nchg; i++)
+        if (r->chg[i]==v)
+          {
+           r->chg[i]=r->chg[--r->nchg];
+           break;
+          }
+ for (v=v->child; v; v=v->next)
+     mi_vreg_unindex(r,v);
+}
+
+static
+void mi_vreg_unindex_children(mi_var_reg *r, mi_gvar *v)
+{
+ for (v=v->child; v; v=v->next)
+     mi_vreg_unindex(r,v);
+}
+
+static
+void mi_vreg_index_children(mi_var_reg *r, mi_gvar *v)
+{
+ for (v=v->child; v; v=v->next)
+     mi_vreg_index(r,v);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Looks for the variable object called @var{name}.
+
+  Return: The variable, owned by the registry, or NULL if not found.
+
+***************************************************************************/
+
+mi_gvar *mi_var_reg_find(mi_var_reg *r, const char *name)
+{
+ mi_gvar *v=r->table[mi_vreg_hash(name) & (r->buckets-1)];
+
+ for (; v; v=v->hnext)
+     if (strcmp(v->name,name)==0)
+        return v;
+ return NULL;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Adds a root variable, and its children, to the registry. The registry
+becomes the owner.
+
+***************************************************************************/
+
+void mi_var_reg_add(mi_var_reg *r, mi_gvar *v)
+{
+ v->parent=NULL;
+ v->next=r->roots;
+ r->roots=v;
+ mi_vreg_index(r,v);
+}
+
+/* Unlinks v from its parent, or the roots, and releases it. */
+static
+void mi_vreg_remove(mi_var_reg *r, mi_gvar *v)
+{
+ mi_gvar **p=v->parent ? &v->parent->child : &r->roots;
+
+ mi_vreg_unindex(r,v);
+ for (; *p; p=&(*p)->next)
+     if (*p==v)
+       {
+        *p=v->next;
+        break;
+       }
+ if (v->parent)
+    v->parent->vischild--;
+ v->next=NULL;
+ mi_free_gvar(v);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates a variable object and adds it to the registry. See
+@x{gmi_full_var_create}.
+
+  Command: -var-create + -var-info-expression + -var-show-attributes
+  Return: The new variable, owned by the registry, or NULL on error.
+
+***************************************************************************/
+
+mi_gvar *gmi_var_reg_create(mi_h *h, mi_var_reg *r, int frame,
+                            const char *exp)
+{
+ mi_gvar *v=gmi_full_var_create(h,frame,exp);
+
+ if (v)
+    mi_var_reg_add(r,v);
+ return v;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Deletes the @var{var} variable object, and its children, from gdb and
+from the registry.
+
+  Command: -var-delete
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_var_reg_delete(mi_h *h, mi_var_reg *r, mi_gvar *var)
+{
+ int ok=gmi_var_delete(h,var);
+
+ mi_vreg_remove(r,var);
+ return ok;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Fetches the children of @var{var}, see @x{gmi_var_list_children}.
+
+  Command: -var-list-children
+  Return: !=0 OK
+
+***************************************************************************/
+
+int gmi_var_reg_list_children(mi_h *h, mi_var_reg *r, mi_gvar *var)
+{
+ int ok;
+
+ mi_vreg_unindex_children(r,var);
+ ok=gmi_var_list_children(h,var);
+ mi_vreg_index_children(r,var);
+ return ok;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Expands the @var{var} subtree, see @x{gmi_var_expand}.
+
+  Command: -var-list-children --all-values
+  Return: The number of nodes fetched or -1 on error.
+
+***************************************************************************/
+
+int gmi_var_reg_expand(mi_h *h, mi_var_reg *r, mi_gvar *var, int max_depth,
+                       int max_nodes)
+{
+ int ret;
+
+ mi_vreg_unindex_children(r,var);
+ ret=gmi_var_expand(h,var,max_depth,max_nodes);
+ mi_vreg_index_children(r,var);
+ return ret;
+}
+
+/* Remembers the changed vars, so we can clear the flag later. */
+static
+int mi_vreg_mark(mi_var_reg *r, mi_gvar *v)
+{
+ if (r->nchg>=r->achg)
+   {
+    int n=r->achg ? r->achg*2 : 64;
+    mi_gvar **c=(mi_gvar **)realloc(r->chg,n*sizeof(mi_gvar *));
+    if (!c)
+      {
+       mi_error=MI_OUT_OF_MEMORY;
+       return 0;
+      }
+    r->chg=c;
+    r->achg=n;
+   }
+ v->changed=1;
+ r->chg[r->nchg++]=v;
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Applies a list of changes reported by -var-update. The changed field of
+the variables that changed in the previous call is cleared. Then: the
+variables that went out of scope are deleted and released, the ones that
+changed the type get the new type and lose the children and the rest are
+marked as changed. If the change includes the value it's stored in the
+variable, when the value is the same we already have the variable isn't
+marked. Changes for unknown variables are ignored.
+
+  Return: The number of variables marked as changed.
+
+***************************************************************************/
+
+int gmi_var_reg_apply(mi_h *h, mi_var_reg *r, mi_gvar_chg *changed)
+{
+ mi_gvar_chg *c;
+ mi_gvar *v;
+ int i;
+
+ for (i=0; i<r->nchg; i++)
+     r->chg[i]->changed=0;
+ r->nchg=0;
+ /* First the changes in the structure. */
+ for (c=changed; c; c=c->next)
+    {
+     if (!c->name || !(v=mi_var_reg_find(r,c->name)))
+        continue;
+     if (!c->in_scope)
+        gmi_var_reg_delete(h,r,v);
+     else if (c->new_type)
+       {/* gdb deleted the children. */
+        free(v->type);
+        v->type=c->new_type;
+        c->new_type=NULL;
+        c->type_changed=1;
+        v->numchild=c->new_num_children;
+        mi_vreg_unindex_children(r,v);
+        mi_free_gvar(v->child);
+        v->child=NULL;
+        v->vischild=0;
+        v->opened=0;
+       }
+    }
+ /* Now mark the ones that still exist. */
+ for (c=changed; c; c=c->next)
+    {
+     if (!c->in_scope || !c->name || !(v=mi_var_reg_find(r,c->name)))
+        continue;
+     if (c->value)
+       {
+        if (v->value && strcmp(v->value,c->value)==0 && !c->type_changed)
+           continue;
+        free(v->value);
+        v->value=c->value;
+        c->value=NULL;
+       }
+     if (!v->changed && !mi_vreg_mark(r,v))
+        break;
+    }
+ return r->nchg;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Updates all the variables and applies the changes, see
+@x{gmi_var_reg_apply}. The new values are requested in the same command
+and stored in the variables.
+
+  Command: -var-update --all-values
+  Return: The number of variables marked as changed or -1 on error.
+
+***************************************************************************/
+
+int gmi_var_reg_update(mi_h *h, mi_var_reg *r)
+{
+ mi_gvar_chg *changed;
+ int ret;
+
+ mi_var_update_v(h,NULL,1);
+ if (!mi_res_changelist(h,&changed))
+    return -1;
+ ret=gmi_var_reg_apply(h,r,changed);
+ mi_free_gvar_chg(changed);
+ return ret;
+}
@@ -0,0 +1,300 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Children windows.
+  Comments:
+  Listing the children of a huge array creates a huge response and a huge
+list of mi_gvar. Here the children are fetched in windows of a fixed size,
+using the from/to arguments of -var-list-children (gdb 7.1 or newer), only
+for the part the user is looking at.@p
+
+  The windows are cached. When the memory used by the cached windows
+exceeds the budget the least recently used ones are released. The windows
+fetched before the last stop are fetched again when used, to get the
+current values.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include "mi_gdb.h"
+
+#define MI_DEF_WIN_SIZE   100
+#define MI_DEF_WIN_BUDGET (1024*1024)
+
+/* From var_obj.c */
+void mi_var_list_children_r(mi_h *h, const char *name, int from, int to);
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates an empty cache for the children of @var{var}. Each window has
+@var{size} children and the cache uses up to @var{budget} bytes. Use 0 for
+the defaults. The variable isn't modified, but must exist while the cache
+is used.
+
+  Return: A new cache or NULL on error. Release it using
+@x{mi_free_child_cache}.
+
+***************************************************************************/
+
+mi_child_cache *mi_new_child_cache(mi_gvar *var, int size, int budget)
+{
+ mi_child_cache *c=(mi_child_cache *)mi_calloc1(sizeof(mi_child_cache));
+
+ if (!c)
+    return NULL;
+ c->var=var;
+ c->size=size>0 ? size : MI_DEF_WIN_SIZE;
+ c->budget=budget>0 ? budget : MI_DEF_WIN_BUDGET;
+ return c;
+}
+
+static
+void mi_free_child_win(mi_child_win *w)
+{
+ mi_free_gvar(w->child);
+ free(w->index);
+ free(w);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Releases all the cached windows.
+
+***************************************************************************/
+
+void mi_child_cache_flush(mi_child_cache *c)
+{
+ mi_child_win *w, *n;
+
+ for (w=c->wins; w; w=n)
+    {
+     n=w->next;
+     mi_free_child_win(w);
+    }
+ c->wins=NULL;
+ c->used=0;
+}
+
+void mi_free_child_cache(mi_child_cache *c)
+{
+ if (!c)
+    return;
+ mi_child_cache_flush(c);
+ free(c);
+}
+
+/* Rough estimation of the memory used by a child. */
+static
+int mi_child_bytes(mi_gvar *v)
+{
+ int b=sizeof(mi_gvar)+sizeof(mi_gvar *);
+
+ if (v->name)
+    b+=strlen(v->name)+1;
+ if (v->exp)
+    b+=strlen(v->exp)+1;
+ if (v->type)
+    b+=strlen(v->type)+1;
+ if (v->value)
+    b+=strlen(v->value)+1;
+ return b;
+}
+
+static
+mi_child_win *mi_child_find_win(mi_child_cache *c, int first)
+{
+ mi_child_win *w;
+
+ for (w=c->wins; w; w=w->next)
+     if (w->first==first)
+        return w;
+ return NULL;
+}
+
+/* Releases the least recently used windows, but not the ones used after
+   stamp. */
+static
+void mi_child_evict(mi_child_cache *c, unsigned stamp)
+{
+ mi_child_win *w, **p, **lru;
+
+ while (c->used>c->budget)
+   {
+    lru=NULL;
+    for (p=&c->wins; (w=*p)!=NULL; p=&w->next)
+        if (w->stamp<stamp && (!lru || w->stamp<(*lru)->stamp))
+           lru=p;
+    if (!lru)
+       return;
+    w=*lru;
+    *lru=w->next;
+    c->used-=w->bytes;
+    mi_free_child_win(w);
+   }
+}
+
+typedef struct
+{
+ mi_child_cache *c;
+ int *firsts;
+} mi_child_batch;
+
+static
+void mi_child_send(mi_h *h, int i, void *data)
+{
+ mi_child_batch *b=(mi_child_batch *)data;
+ int first=b->firsts[i];
+
+ mi_var_list_children_r(h,b->c->var->name,first,first+b->c->size);
+}
+
+static
+int mi_child_recv(mi_h *h, int i, void *data)
+{
+ mi_child_batch *b=(mi_child_batch *)data;
+ mi_child_cache *c=b->c;
+ mi_child_win *w, **p;
+ mi_gvar tmp, *v;
+ int n;
+
+ /* A shell to collect the children without touching the variable. */
+ memset(&tmp,0,sizeof(tmp));
+ tmp.depth=c->var->depth;
+ if (!mi_res_children(h,&tmp))
+   {
+    mi_free_gvar(tmp.child);
+    return 0;
+   }
+ w=(mi_child_win *)mi_calloc1(sizeof(mi_child_win));
+ n=tmp.vischild;
+ if (w && n)
+    w->index=(mi_gvar **)mi_malloc(n*sizeof(mi_gvar *));
+ if (!w || (n && !w->index))
+   {
+    free(w);
+    mi_free_gvar(tmp.child);
+    return 0;
+   }
+ w->first=b->firsts[i];
+ w->count=n;
+ w->child=tmp.child;
+ w->stop_gen=mi_get_stop_gen(h);
+ w->stamp=++c->clock;
+ for (n=0, v=w->child; v; v=v->next, n++)
+    {
+     v->parent=c->var;
+     w->index[n]=v;
+     w->bytes+=mi_child_bytes(v);
+    }
+ /* Replace the old copy, if any. */
+ for (p=&c->wins; *p; p=&(*p)->next)
+     if ((*p)->first==w->first)
+       {
+        mi_child_win *old=*p;
+        *p=old->next;
+        c->used-=old->bytes;
+        mi_free_child_win(old);
+        break;
+       }
+ w->next=c->wins;
+ c->wins=w;
+ c->used+=w->bytes;
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Makes sure the children from @var{from} to @var{to} (inclusive) are in
+the cache. The missing windows are requested in a pipeline. Then the
+cache is trimmed to the budget, the windows in this range are kept.
+
+  Command: -var-list-children --all-values
+  Return: The number of windows fetched or -1 on error.
+
+***************************************************************************/
+
+int gmi_child_cache_fetch(mi_h *h, mi_child_cache *c, int from, int to)
+{
+ mi_child_batch b;
+ mi_child_win *w;
+ unsigned gen=mi_get_stop_gen(h), stamp;
+ int first, n=0, ret;
+
+ if (from<0)
+    from=0;
+ if (to>=c->var->numchild)
+    to=c->var->numchild-1;
+ if (from>to)
+    return 0;
+ b.c=c;
+ b.firsts=(int *)mi_malloc(((to-from)/c->size+2)*sizeof(int));
+ if (!b.firsts)
+    return -1;
+ stamp=c->clock+1;
+ for (first=from-from%c->size; first<=to; first+=c->size)
+    {
+     w=mi_child_find_win(c,first);
+     if (w && w->stop_gen==gen)
+        w->stamp=++c->clock;
+     else
+        b.firsts[n++]=first;
+    }
+ ret=n ? mi_pipeline(h,n,mi_child_send,mi_child_recv,&b) : 0;
+ free(b.firsts);
+ /* Trim, but keep what we just used. */
+ mi_child_evict(c,stamp);
+ return ret;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Gets the child number @var{index} of the variable, fetching its window
+if needed.
+
+  Command: -var-list-children --all-values
+  Return: The child, owned by the cache, or NULL on error. The pointer is
+valid until the window is released by the cache.
+
+***************************************************************************/
+
+mi_gvar *gmi_child_cache_get(mi_h *h, mi_child_cache *c, int index)
+{
+ int first;
+ mi_child_win *w;
+
+ if (index<0 || index>=c->var->numchild)
+    return NULL;
+ first=index-index%c->size;
+ w=mi_child_find_win(c,first);
+ if (!w || w->stop_gen!=mi_get_stop_gen(h))
+   {
+    if (gmi_child_cache_fetch(h,c,index,index)<=0)
+       return NULL;
+    w=mi_child_find_win(c,first);
+   }
+ else
+    w->stamp=++c->clock;
+ if (!w || index-first>=w->count)
+    return NULL;
+ return w->index[index-first];
+}
@@ -0,0 +1,446 @@
+/**[txh]********************************************************************
+
+  GDB/MI interface library
+  Copyright (c) 2016 by Salvador E. Tropea.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Module: Watchpoint manager.
+  Comments:
+  The CPUs have a few debug registers for hardware watchpoints. Each one
+watches an aligned block of a few bytes. When gdb can't use them it
+silently creates a software watchpoint, single stepping the target and
+making it about 1000 times slower.@p
+
+  The manager knows how many slots the architecture has and how big a slot
+can be. The ranges to watch are split in aligned blocks, the blocks
+already watched with the same mode are shared and the requests that need
+more slots than available are rejected. After inserting, -break-list is
+used to verify gdb really used hardware watchpoints.@p
+
+  The blocks are watched using "*(char (*)[len])addr", so they don't go out
+of scope.@p
+
+***************************************************************************/
+
+#include <string.h>
+#include "mi_gdb.h"
+
+/* From breakpoint.c */
+void mi_break_watch(mi_h *h, enum mi_wp_mode mode, const char *exp);
+void mi_break_delete(mi_h *h, int number);
+void mi_break_list(mi_h *h);
+/* From data_man.c */
+void mi_data_evaluate_expression(mi_h *h, const char *expression);
+
+typedef struct
+{
+ const char *arch; /* Prefix of the name reported by gdb. */
+ int slots, max_len;
+} mi_wman_arch;
+
+/* Conservative values, some CPUs have more. */
+static
+mi_wman_arch mi_wman_archs[]=
+{
+ { "i386:x86-64", 4, 8 },
+ { "i386", 4, 4 },
+ { "aarch64", 4, 8 },
+ { "arm", 4, 4 },
+ { "powerpc", 1, 8 },
+ { "rs6000", 1, 8 },
+ { "mips", 1, 8 },
+ { NULL, 4, 4 }
+};
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates a watchpoint manager for a CPU with @var{slots} hardware
+watchpoints of up to @var{max_len} bytes (a power of 2).
+
+  Return: A new manager or NULL on error. Release it using
+@x{mi_free_watch_man}.
+
+***************************************************************************/
+
+mi_watch_man *mi_new_watch_man(int slots, int max_len)
+{
+ mi_watch_man *m=(mi_watch_man *)mi_calloc1(sizeof(mi_watch_man));
+
+ if (!m)
+    return NULL;
+ m->slots=slots;
+ m->max_len=max_len>0 ? max_len : 1;
+ return m;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Creates a watchpoint manager for the @var{arch} architecture, the name
+reported by "show architecture" (i.e. MIDebugger::GetArchKey). Unknown
+architectures get 4 slots of 4 bytes.
+
+  Return: A new manager or NULL on error.
+
+***************************************************************************/
+
+mi_watch_man *mi_new_watch_man_arch(const char *arch)
+{
+ mi_wman_arch *a;
+
+ for (a=mi_wman_archs; a->arch; a++)
+     if (arch && strncmp(arch,a->arch,strlen(a->arch))==0)
+        break;
+ return mi_new_watch_man(a->slots,a->max_len);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Releases the manager. The watchpoints aren't deleted in gdb.
+
+***************************************************************************/
+
+void mi_free_watch_man(mi_watch_man *m)
+{
+ mi_wman_ent *e, *n;
+
+ if (!m)
+    return;
+ for (e=m->ents; e; e=n)
+    {
+     n=e->next;
+     free(e);
+    }
+ free(m);
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Splits the range @var{addr}, @var{len} in aligned blocks that fit in a
+slot. If @var{exact} is 0 the blocks are the aligned blocks of the maximum
+size that cover the range, they use less slots, but a read or access
+watchpoint could trigger for bytes outside the range. Otherwise the
+blocks cover exactly the range. At most @var{max} blocks are stored in
+@var{addrs} and @var{lens}.
+
+  Return: The number of blocks needed, can be bigger than @var{max}.
+
+***************************************************************************/
+
+int mi_watch_man_split(mi_watch_man *m, void *addr, int len, int exact,
+                       void **addrs, int *lens, int max)
+{
+ unsigned long a=(unsigned long)addr, end=a+len, size;
+ int n=0;
+
+ if (!exact)
+    a&=~(unsigned long)(m->max_len-1);
+ while (a<end)
+   {
+    size=m->max_len;
+    if (exact)
+       while (size>1 && ((a & (size-1)) || a+size>end))
+          size/=2;
+    if (n<max)
+      {
+       addrs[n]=(void *)a;
+       lens[n]=size;
+      }
+    n++;
+    a+=size;
+   }
+ return n;
+}
+
+static
+mi_wman_ent *mi_wman_find(mi_watch_man *m, void *addr, int len,
+                          enum mi_wp_mode mode)
+{
+ mi_wman_ent *e;
+
+ for (e=m->ents; e; e=e->next)
+     if (e->addr==addr && e->len==len && e->mode==mode)
+        return e;
+ return NULL;
+}
+
+/* Insert. */
+typedef struct
+{
+ void **addrs;
+ int *lens;
+ int *numbers;
+ enum mi_wp_mode mode;
+ mi_bkpt *list;
+} mi_wman_batch;
+
+static
+void mi_wman_send(mi_h *h, int i, void *data)
+{
+ mi_wman_batch *b=(mi_wman_batch *)data;
+ char exp[64];
+
+ if (b->addrs[i])
+   {
+    snprintf(exp,64,"*(char (*)[%d])%p",b->lens[i],b->addrs[i]);
+    mi_break_watch(h,b->mode,exp);
+   }
+ else
+    mi_break_list(h);
+}
+
+static
+int mi_wman_recv(mi_h *h, int i, void *data)
+{
+ mi_wman_batch *b=(mi_wman_batch *)data;
+ mi_wp *w;
+
+ if (!b->addrs[i])
+   {
+    b->list=mi_res_break_list(h);
+    return b->list!=NULL;
+   }
+ w=mi_res_wp(h);
+ if (!w)
+    return 0;
+ b->numbers[i]=w->number;
+ mi_free_wp(w);
+ return 1;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Watches the range @var{addr}, @var{len}. The range is split in blocks
+(see @x{mi_watch_man_split}) and the blocks already watched with the same
+@var{mode} are shared. If the new blocks don't fit in the free slots the
+request is rejected, unless MI_WM_ALLOW_SW is in @var{flags}. Use
+MI_WM_EXACT to avoid watching bytes outside the range. The watchpoints and
+a -break-list are sent in a pipeline, if gdb created software
+watchpoints they are deleted and the request fails, unless
+MI_WM_ALLOW_SW is used.
+
+  Command: -break-watch + -break-list
+  Return: The number of blocks used by the range. MI_WM_NO_SLOTS if there
+are no free slots, MI_WM_SOFTWARE if gdb didn't use hardware watchpoints
+or -1 on error.
+
+***************************************************************************/
+
+int gmi_watch_man_range(mi_h *h, mi_watch_man *m, void *addr, int len,
+                        enum mi_wp_mode mode, int flags)
+{
+ mi_wman_batch b;
+ mi_wman_ent *e;
+ mi_bkpt *bk;
+ void **addrs;
+ int *lens, n, i, j, nnew=0, sw=0, ret;
+
+ b.list=NULL;
+
+ if (len<=0)
+    return -1;
+ n=mi_watch_man_split(m,addr,len,flags & MI_WM_EXACT,NULL,NULL,0);
+ addrs=(void **)mi_malloc((n+1)*sizeof(void *));
+ lens=(int *)mi_malloc((n+1)*sizeof(int));
+ b.numbers=(int *)mi_calloc(n+1,sizeof(int));
+ if (!addrs || !lens || !b.numbers)
+   {
+    free(addrs);
+    free(lens);
+    free(b.numbers);
+    return -1;
+   }
+ mi_watch_man_split(m,addr,len,flags & MI_WM_EXACT,addrs,lens,n);
+ /* Keep only the new blocks, the rest are shared. */
+ for (i=0; i<n; i++)
+     if (!mi_wman_find(m,addrs[i],lens[i],mode))
+       {
+        addrs[nnew]=addrs[i];
+        lens[nnew++]=lens[i];
+       }
+ if (m->used+nnew>m->slots && !(flags & MI_WM_ALLOW_SW))
+   {
+    ret=MI_WM_NO_SLOTS;
+    goto out;
+   }
+ ret=n;
+ if (nnew)
+   {/* The last one is the -break-list. */
+    addrs[nnew]=NULL;
+    b.addrs=addrs;
+    b.lens=lens;
+    b.mode=mode;
+    if (mi_pipeline(h,nnew+1,mi_wman_send,mi_wman_recv,&b)<0)
+      {
+       ret=-1;
+       goto out;
+      }
+    for (bk=b.list; bk; bk=bk->next)
+        if (bk->type==t_watchpoint)
+           for (j=0; j<nnew; j++)
+               if (b.numbers[j]==bk->number)
+                  sw++;
+    for (j=0; j<nnew; j++)
+        if (!b.numbers[j])
+           ret=-1;
+    if (ret<0 || (sw && !(flags & MI_WM_ALLOW_SW)))
+      {/* Undo. */
+       for (j=0; j<nnew; j++)
+           if (b.numbers[j])
+              gmi_break_delete(h,b.numbers[j]);
+       if (ret>=0)
+          ret=MI_WM_SOFTWARE;
+       goto out;
+      }
+    for (j=0; j<nnew; j++)
+       {
+        e=(mi_wman_ent *)mi_calloc1(sizeof(mi_wman_ent));
+        if (!e)
+          {
+           ret=-1;
+           break;
+          }
+        e->number=b.numbers[j];
+        e->addr=addrs[j];
+        e->len=lens[j];
+        e->mode=mode;
+        e->hw=1;
+        for (bk=b.list; bk; bk=bk->next)
+            if (bk->number==e->number && bk->type==t_watchpoint)
+               e->hw=0;
+        e->next=m->ents;
+        m->ents=e;
+        /* Software watchpoints don't use slots. */
+        if (e->hw)
+           m->used++;
+       }
+   }
+ if (ret>=0)
+   {/* Now all the blocks exist, count the references. */
+    mi_watch_man_split(m,addr,len,flags & MI_WM_EXACT,addrs,lens,n);
+    for (i=0; i<n; i++)
+        if ((e=mi_wman_find(m,addrs[i],lens[i],mode))!=NULL)
+           e->refs++;
+   }
+out:
+ mi_free_bkpt(b.list);
+ free(addrs);
+ free(lens);
+ free(b.numbers);
+ return ret;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Releases a range watched with @x{gmi_watch_man_range}, use the same
+arguments. The blocks that aren't used by other ranges are deleted.
+
+  Command: -break-delete
+  Return: The number of slots freed or -1 on error.
+
+***************************************************************************/
+
+int gmi_watch_man_release(mi_h *h, mi_watch_man *m, void *addr, int len,
+                          enum mi_wp_mode mode, int flags)
+{
+ mi_wman_ent *e, **p;
+ void **addrs;
+ int *lens, i, n, freed=0;
+
+ if (len<=0)
+    return -1;
+ n=mi_watch_man_split(m,addr,len,flags & MI_WM_EXACT,NULL,NULL,0);
+ addrs=(void **)mi_malloc(n*sizeof(void *));
+ lens=(int *)mi_malloc(n*sizeof(int));
+ if (!addrs || !lens)
+   {
+    free(addrs);
+    free(lens);
+    return -1;
+   }
+ mi_watch_man_split(m,addr,len,flags & MI_WM_EXACT,addrs,lens,n);
+ for (i=0; i<n; i++)
+    {
+     for (p=&m->ents; (e=*p)!=NULL; p=&e->next)
+         if (e->addr==addrs[i] && e->len==lens[i] && e->mode==mode)
+            break;
+     if (!e || --e->refs>0)
+        continue;
+     if (!gmi_break_delete(h,e->number))
+       {
+        freed=-1;
+        break;
+       }
+     *p=e->next;
+     if (e->hw)
+       {
+        m->used--;
+        freed++;
+       }
+     free(e);
+    }
+ free(addrs);
+ free(lens);
+ return freed;
+}
+
+/**[txh]********************************************************************
+
+  Description:
+  Watches the memory used by the @var{exp} expression, i.e. a variable or
+a structure member. The address and the size are evaluated in a pipeline,
+then @x{gmi_watch_man_range} is used. The address is stored in
+@var{addr} and the size in @var{len}, needed to release it.
+
+  Command: -data-evaluate-expression + -break-watch + -break-list
+  Return: See @x{gmi_watch_man_range}.
+
+***************************************************************************/
+
+int gmi_watch_man_exp(mi_h *h, mi_watch_man *m, const char *exp,
+                      enum mi_wp_mode mode, int flags, void **addr, int *len)
+{
+ char *v[2]={NULL,NULL}, *e;
+ int i, ret=-1;
+
+ e=(char *)mi_malloc(strlen(exp)+16);
+ if (!e)
+    return -1;
+ for (i=0; i<2; i++)
+    {
+     sprintf(e,i ? "sizeof(%s)" : "&(%s)",exp);
+     mi_data_evaluate_expression(h,e);
+    }
+ for (i=0; i<2; i++)
+     v[i]=mi_res_value(h);
+ free(e);
+ if (v[0] && v[1])
+   {/* The address can be followed by a symbol: 0x601040 <x> */
+    e=strstr(v[0],"0x");
+    *addr=e ? (void *)strtoul(e,NULL,16) : NULL;
+    *len=atoi(v[1]);
+    if (*addr && *len>0)
+       ret=gmi_watch_man_range(h,m,*addr,*len,mode,flags);
+   }
+ free(v[0]);
+ free(v[1]);
+ return ret;
+}